@@ -5,13 +5,22 @@ mkdir -p webdemo
 
 echo "Compiling eelib to WebAssembly..."
 
+# abm.cpp links against threadpool.cpp and trace.cpp. The demo never asks for policy threads, which would need
+# -pthread, or starts a trace, which only writes into emscripten's in memory file system
+
 emcc -O3 \
     eelib/wasm_bindings.cpp \
     eelib/abm.cpp \
     eelib/agent.cpp \
+    eelib/latency.cpp \
     eelib/matcher.cpp \
     eelib/notifier.cpp \
+    eelib/observation.cpp \
     eelib/order.cpp \
+    eelib/population.cpp \
+    eelib/symbol.cpp \
+    eelib/threadpool.cpp \
+    eelib/trace.cpp \
     -I eelib \
     -std=c++17 \
     -lembind \
@@ -1,117 +1,389 @@
 #include "abm.h"
 #include "utils.h"
+#include <algorithm>
+#include <stdexcept>
 
 void ABM::observe(){
     latestObservation.time = tickCounter;
     for(auto& it : orderMatchers){
-        latestObservation.assetSpreads[it.first] = it.second.getSpread();
-        latestObservation.assetOrderDepths[it.first] = it.second.getDepth();
+        unsigned long version = it.second.getVersion();
+        auto observed = observedVersions.find(it.first);
+        if(observed != observedVersions.end() && observed->second == version){
+            continue; // Idle since the last observation
+        }
+        observedVersions[it.first] = version;
+
+        auto levels = assetDepthLevels.find(it.first);
+        it.second.getDepth(depthBuffer, levels == assetDepthLevels.end() ? depthLevels : levels->second);
+        latestObservation.setBook(it.first, it.second.getSpread(), depthBuffer);
     };
 };
 
-void ABM::addMatcherIfNeeded(const std::string& asset){
+void ABM::setDepthLevels(size_t levels){
+    depthLevels = levels;
+
+    // Every book needs reading again
+    observedVersions.clear();
+    observe();
+}
+
+void ABM::setDepthLevels(Symbol asset, size_t levels){
+    assetDepthLevels[asset] = levels;
+    observedVersions.erase(asset);
+    observe();
+}
+
+void ABM::addMatcherIfNeeded(Symbol asset){
     if(orderMatchers.find(asset) == orderMatchers.end()){
-        orderMatchers.emplace(asset, Matcher(&notifier));
+        auto it = orderMatchers.emplace(asset, Matcher(&notifier)).first;
+        it->second.setMode(auctionInterval > 0 ? AUCTION : CONTINUOUS);
+        if(trace) trace->mode(asset, it->second.getMode());
     }
 };
 
+void ABM::setAuctionInterval(unsigned long steps){
+    auctionInterval = steps;
+    for(auto& it : orderMatchers){
+        it.second.setMode(auctionInterval > 0 ? AUCTION : CONTINUOUS);
+        if(trace) trace->mode(it.first, it.second.getMode());
+    }
+}
+
+void ABM::startTrace(const std::string& path){
+    // A replay starts from empty books, so it can't know about these
+    if(!orderBooks.empty()){
+        throw std::logic_error("Can't start a trace while orders rest on the books");
+    }
+    stopTrace();
+    trace = std::make_unique<TraceWriter>(path);
+
+    // Books made before the trace start in the right mode on replay
+    for(auto& it : orderMatchers){
+        trace->mode(it.first, it.second.getMode());
+    }
+}
+
+void ABM::stopTrace(){
+    if(!trace) return;
+    std::unique_ptr<TraceWriter> finished = std::move(trace);
+    finished->close();
+}
+
 void ABM::routeMatches(std::vector<Match>& matches){
-    
-    // TODO: This sort should be moved so its not repeated constantly. But where?
-    std::sort(agents.begin(), agents.end(), 
-        [](const std::unique_ptr<Agent>& a,
-        const std::unique_ptr<Agent>& b)
-        {return a->traderId < b->traderId; });
-
-    // Sort by buyers.
-    std::sort(matches.begin(), matches.end(),
-            [](const Match& a, const Match& b)
-            {return a.buyer.traderId < b.buyer.traderId; });
-
-    // Route matches to buyers
-    size_t agentIdx = 0;
+    // Filled orders are off their books
     for(auto& match : matches){
-        while(agentIdx < agents.size() && agents[agentIdx]->traderId < match.buyer.traderId){
-            ++agentIdx;
+        if(match.buyerFilled) orderBooks.erase(match.buyer.ordId);
+        if(match.sellerFilled) orderBooks.erase(match.seller.ordId);
+    }
+
+    // Count fills per agent, giving each agent an inbox the first time it shows up.
+    // Population members' fills go straight to their population
+    auto countFill = [&](long traderId, const Match& match){
+        AgentSlot* slot = findSlot(traderId);
+        if(!slot || !slot->agent){
+            size_t member;
+            if(PopulationBlock* block = findPopulation(traderId, member)){
+                block->fills.push_back(MemberFill{member, match});
+            }
+            return;
         }
-        if (agentIdx < agents.size() && agents[agentIdx]->traderId == match.buyer.traderId) {
-            agents[agentIdx]->matchFound(match, tickCounter);
+        if(slot->inbox == noInbox){
+            slot->inbox = touchedAgents.size();
+            touchedAgents.push_back(slot);
+            inboxStart.push_back(0);
         }
+        ++inboxStart[slot->inbox];
+    };
+    for(auto& match : matches){
+        countFill(match.buyer.traderId, match);
+        countFill(match.seller.traderId, match);
     }
 
-    // Sort by sellers.
-    std::sort(matches.begin(), matches.end(),
-        [](const Match& a, const Match& b)
-        {return a.seller.traderId < b.seller.traderId; });
-
-    // Route matches to sellers
-    agentIdx = 0;
+    // Turn counts into where each inbox starts, then drop every fill into place.
+    // Afterwards each entry points at the end of its inbox, which is where the next one starts
+    size_t total = 0;
+    for(auto& start : inboxStart){
+        size_t count = start;
+        start = total;
+        total += count;
+    }
+    inboxFills.resize(total);
+    auto deliver = [&](long traderId, const Match& match){
+        AgentSlot* slot = findSlot(traderId);
+        if(!slot || !slot->agent) return;
+        inboxFills[inboxStart[slot->inbox]++] = match;
+    };
     for(auto& match : matches){
-        while(agentIdx < agents.size() && agents[agentIdx]->traderId < match.seller.traderId){
-            ++agentIdx;
-        }
-        if (agentIdx < agents.size() && agents[agentIdx]->traderId == match.seller.traderId) {
-            agents[agentIdx]->matchFound(match, tickCounter);
-        }
+        deliver(match.buyer.traderId, match);
+        deliver(match.seller.traderId, match);
     }
-    
+
+    // One call per agent
+    size_t begin = 0;
+    for(size_t i = 0; i < touchedAgents.size(); ++i){
+        AgentSlot& slot = *touchedAgents[i];
+        slot.agent->matchesFound(MatchSpan{inboxFills.data() + begin, inboxStart[i] - begin}, tickCounter);
+        slot.inbox = noInbox;
+        begin = inboxStart[i];
+    }
+
+    flushPopulationEvents(&PopulationBlock::fills, &Population::matchesFound);
+
+    touchedAgents.clear();
+    inboxStart.clear();
     matches.clear();
 };
 
-void ABM::cancelOrderWithAllMatchers(long doomedOrderId){
-    for(auto& it : orderMatchers){
-        it.second.cancelOrder(doomedOrderId);
-    };
+ABM::AgentSlot* ABM::findSlot(long traderId){
+    // Last range starting at or before the id
+    auto it = std::upper_bound(agentsById.begin(), agentsById.end(), traderId,
+        [](long traderId, const AgentRange& range)
+        {return traderId < range.firstTraderId; });
+    if(it == agentsById.begin()){
+        return nullptr;
+    }
+    --it;
+    size_t slot = (size_t)(traderId - it->firstTraderId);
+    return slot < it->slots.size() ? &it->slots[slot] : nullptr;
 }
 
-void ABM::simStep(){
-    // update latest observation
-    observe();
+Agent* ABM::findAgent(long traderId){
+    AgentSlot* slot = findSlot(traderId);
+    return slot ? slot->agent : nullptr;
+}
+
+ABM::PopulationBlock* ABM::findPopulation(long traderId, size_t& member){
+    // Last population starting at or before the id
+    auto it = std::upper_bound(populations.begin(), populations.end(), traderId,
+        [](long traderId, const PopulationBlock& block)
+        {return traderId < block.firstTraderId; });
+    if(it == populations.begin()){
+        return nullptr;
+    }
+    --it;
+    member = (size_t)(traderId - it->firstTraderId);
+    return member < it->population->size() ? &*it : nullptr;
+}
+
+void ABM::routeToPopulation(long traderId, std::vector<MemberOrderId> PopulationBlock::* events, long ordId){
+    size_t member;
+    if(PopulationBlock* block = findPopulation(traderId, member)){
+        (block->*events).push_back(MemberOrderId{member, ordId});
+    }
+}
+
+template<typename Event>
+void ABM::flushPopulationEvents(std::vector<Event> PopulationBlock::* events,
+    void (Population::* callback)(const std::vector<Event>&, tick)){
+    for(auto& block : populations){
+        if((block.*events).empty()) continue;
+        (block.population.get()->*callback)(block.*events, tickCounter);
+        (block.*events).clear();
+    }
+}
+
+void ABM::routeCanceledOrders(std::vector<Order>& canceledOrders){
+    for(auto& order : canceledOrders){
+        orderBooks.erase(order.ordId);
+        if(Agent* agent = findAgent(order.traderId)){
+            agent->orderCanceled(order.ordId, tickCounter);
+        }
+        else{
+            routeToPopulation(order.traderId, &PopulationBlock::canceled, order.ordId);
+        }
+    }
+    flushPopulationEvents(&PopulationBlock::canceled, &Population::ordersCanceled);
+
+    canceledOrders.clear();
+}
 
-    // Execute actions for all agents
-    for(auto& agent: agents){
-        auto action = agent->policy(latestObservation);
-        
-        if(action.cancelOrder){
-            cancelOrderWithAllMatchers(action.doomedOrderId);
-            agent->orderCanceled(action.doomedOrderId, tickCounter);
+void ABM::routePlacedOrders(std::vector<Order>& placedOrders){
+    for(auto& order : placedOrders){
+        orderBooks[order.ordId] = OpenOrder{&orderMatchers.at(order.asset), order.asset};
+        if(Agent* agent = findAgent(order.traderId)){
+            agent->orderPlaced(order.ordId, tickCounter);
+        }
+        else{
+            routeToPopulation(order.traderId, &PopulationBlock::placed, order.ordId);
+        }
+    }
+    flushPopulationEvents(&PopulationBlock::placed, &Population::ordersPlaced);
+
+    placedOrders.clear();
+}
+
+void ABM::cancelOrder(long doomedOrderId){
+    auto it = orderBooks.find(doomedOrderId);
+    if(it == orderBooks.end()){
+        return; // Already filled or canceled
+    }
+    it->second.book->cancelOrder(doomedOrderId);
+    if(trace) trace->cancel(it->second.asset, doomedOrderId);
+    orderBooks.erase(it);
+}
+
+void ABM::setPolicyThreads(size_t numThreads){
+    if(numThreads > 1){
+        policyPool = std::make_unique<ThreadPool>(numThreads);
+    }
+    else{
+        policyPool.reset();
+    }
+}
+
+void ABM::evaluatePolicies(){
+    actions.resize(agents.size());
+    auto evaluate = [&](size_t begin, size_t end){
+        for(size_t i = begin; i < end; ++i){
+            actions[i] = agents[i]->policy(latestObservation);
+        }
+    };
+
+    if(policyPool){
+        policyPool->parallelFor(agents.size(), evaluate);
+    }
+    else{
+        evaluate(0, agents.size());
+    }
+
+    // Each population is split into a fixed number of member ranges. Results are applied range by range,
+    // so where the ranges end doesn't change anything
+    size_t numChunks = policyPool ? policyPool->size() * 4 : 1;
+    for(auto& block : populations){
+        size_t numMembers = block.population->size();
+        block.chunkActions.resize(numChunks);
+        auto evaluateChunks = [&](size_t begin, size_t end){
+            for(size_t chunk = begin; chunk < end; ++chunk){
+                block.chunkActions[chunk].clear();
+                block.population->policies(latestObservation,
+                    numMembers * chunk / numChunks, numMembers * (chunk + 1) / numChunks, block.chunkActions[chunk]);
+            }
         };
 
-        if(action.placeOrder){
-            Order order{action.order};
+        if(policyPool){
+            policyPool->parallelFor(numChunks, evaluateChunks);
+        }
+        else{
+            evaluateChunks(0, numChunks);
+        }
+    }
+}
+
+void ABM::applyAction(Agent& agent, const Action& action){
+    // Cancels take effect right away, orders are batched per asset
+    if(action.cancelOrder){
+        cancelOrder(action.doomedOrderId);
+        agent.orderCanceled(action.doomedOrderId, tickCounter);
+    };
+
+    if(action.placeOrder){
+        Order order{action.order};
+        order.ordId = ++nextOrderId;
+        order.traderId = agent.traderId;
+        pendingOrders[order.asset].push_back(order);
+    }
+}
+
+void ABM::applyPopulationActions(PopulationBlock& block){
+    // Same as applyAction, member by member. Cancels all land before orders reach the books either way
+    for(auto& actions : block.chunkActions){
+        for(auto& cancel : actions.cancels){
+            cancelOrder(cancel.ordId);
+            block.canceled.push_back(cancel);
+        }
+        for(auto& memberOrder : actions.orders){
+            Order order{memberOrder.order};
             order.ordId = ++nextOrderId;
-            addMatcherIfNeeded(order.asset);
-
-            // TODO: delay matching until all orders are added?
-            orderMatchers.at(order.asset).addOrder(order);
-            
-            if(!notifier.placedOrders.empty() && notifier.placedOrders.back().ordId == order.ordId){
-                notifier.placedOrders.pop_back();
-                agent->orderPlaced(order.ordId, tickCounter);
-            }
-            else if(!notifier.placementFailedOrders.empty() && notifier.placementFailedOrders.back().ordId == order.ordId)
-            {
-                notifier.placementFailedOrders.pop_back();
-                // TODO: notify placement failed?
+            order.traderId = block.firstTraderId + (long)memberOrder.member;
+            pendingOrders[order.asset].push_back(order);
+        }
+    }
+}
+
+void ABM::simStep(){
+    // latestObservation is kept current by the end of the last step, and by removeAgents
+    // Policies only read the observation, so all of them run before any action is applied.
+    // Agents and populations are both kept in trader id order and a population's ids are one block,
+    // so merging the two applies every action in trader id order
+    evaluatePolicies();
+    size_t nextAgent = 0;
+    for(auto& block : populations){
+        while(nextAgent < agents.size() && agents[nextAgent]->traderId < block.firstTraderId){
+            applyAction(*agents[nextAgent], actions[nextAgent]);
+            ++nextAgent;
+        }
+        applyPopulationActions(block);
+    }
+    for(; nextAgent < agents.size(); ++nextAgent){
+        applyAction(*agents[nextAgent], actions[nextAgent]);
+    }
+    flushPopulationEvents(&PopulationBlock::canceled, &Population::ordersCanceled);
+
+    // One matching pass per asset
+    for(auto& it : pendingOrders){
+        if(it.second.empty()) continue;
+        addMatcherIfNeeded(it.first);
+        if(trace){
+            for(auto& order : it.second) trace->order(order);
+            trace->submit(it.first, it.second.size());
+        }
+        orderMatchers.at(it.first).addOrders(it.second);
+        it.second.clear();
+    }
+
+    routePlacedOrders(notifier.placedOrders);
+    // TODO: notify placement failed?
+    notifier.placementFailedOrders.clear();
+
+    // Each step is a trading day, unless orders are collected for an auction
+    bool endOfDay = auctionInterval == 0 || (tickCounter.raw() + 1) % auctionInterval == 0;
+    if(endOfDay){
+        for(auto& it : orderMatchers){
+            if(auctionInterval > 0){
+                it.second.uncross();
+                if(trace) trace->uncross(it.first);
             }
+            it.second.expireDayOrders();
+            if(trace) trace->expire(it.first);
         }
-    };
+    }
 
     routeMatches(notifier.matches);
+    routeCanceledOrders(notifier.canceledOrders);
+    if(trace) trace->tickEnded(tickCounter);
     ++tickCounter;
 
-    // observe again to keep latestObservation up to date.
-    // TODO: fix this double work
+    // Policies see this next step
     observe();
 };
 
 long ABM::addAgent(std::unique_ptr<Agent> agent){
     long id = nextTraderId++;
     agent->traderId = id;
+    // Carry on the last range unless a population took the ids in between
+    if(agentsById.empty() || agentsById.back().firstTraderId + (long)agentsById.back().slots.size() != id){
+        agentsById.push_back(AgentRange{id, {}});
+    }
+    agentsById.back().slots.push_back(AgentSlot{agent.get()});
     agents.push_back(std::move(agent));
     return id;
 }
 
+long ABM::addPopulation(std::unique_ptr<Population> population){
+    long firstTraderId = nextTraderId;
+    nextTraderId += (long)population->size();
+    populations.emplace_back(firstTraderId, std::move(population));
+    return firstTraderId;
+}
+
+size_t ABM::getNumPopulationMembers() const{
+    size_t numMembers = 0;
+    for(auto& block : populations){
+        numMembers += block.population->size();
+    }
+    return numMembers;
+}
+
 void ABM::removeAgents(AgentSelector& agentSelector){
     std::vector<size_t> agentsToRemove{};
     size_t numAgents = agents.size();
@@ -124,14 +396,18 @@ void ABM::removeAgents(AgentSelector& agentSelector){
             // Carry out final will
             auto finalAction = agent->lastWill(latestObservation);
             if(finalAction.cancelOrder){
-                cancelOrderWithAllMatchers(finalAction.doomedOrderId);
+                cancelOrder(finalAction.doomedOrderId);
             }
             // TODO: Order placements after death not enforceable yet. fine for now
 
+            findSlot(agent->traderId)->agent = nullptr;
             agentsToRemove.push_back(i);
         }
     }
 
     // Out to pasture
     removeIdxs<std::unique_ptr<Agent>>(agents, agentsToRemove);
+
+    // Last wills may have canceled orders
+    observe();
 }
\ No newline at end of file
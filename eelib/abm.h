@@ -4,6 +4,9 @@
 #include <unordered_map>
 #include "matcher.h"
 #include "agent.h"
+#include "population.h"
+#include "threadpool.h"
+#include "trace.h"
 
 
 class AgentSelector{
@@ -13,29 +16,156 @@ class AgentSelector{
 
 /// @brief Agent Based Model. Framework for multi agent trading simulations.
 class ABM{
+    /// @brief Kept in trader id order: ids only grow and removal keeps the order
     std::vector<std::unique_ptr<Agent>> agents;
+
+    struct AgentSlot{
+        /// @brief nullptr once the agent is removed
+        Agent* agent = nullptr;
+        /// @brief Position in touchedAgents while fills are being routed, noInbox otherwise
+        size_t inbox = noInbox;
+    };
+    static constexpr size_t noInbox = (size_t)-1;
+
+    /// @brief Agents holding trader ids firstTraderId, firstTraderId + 1, ... in slot order
+    struct AgentRange{
+        long firstTraderId;
+        std::vector<AgentSlot> slots;
+    };
+
+    /// @brief Trader id - agent, in trader id order. Agents added back to back share a range;
+    /// a population in between starts a new one, so population ids never take up slots
+    std::vector<AgentRange> agentsById;
+
+    /// @brief A population and what happened to its members this step
+    struct PopulationBlock{
+        /// @brief Members hold trader ids firstTraderId, firstTraderId + 1, ... in member order
+        long firstTraderId;
+        std::unique_ptr<Population> population;
+
+        /// @brief Decisions of each range of members evaluated together, in member order
+        std::vector<PopulationActions> chunkActions;
+
+        /// @brief Collected while routing and handed over in one call each
+        std::vector<MemberOrderId> placed;
+        std::vector<MemberOrderId> canceled;
+        std::vector<MemberFill> fills;
+
+        PopulationBlock(long firstTraderId_, std::unique_ptr<Population> population_) :
+            firstTraderId(firstTraderId_), population(std::move(population_)) {}
+    };
+
+    /// @brief In trader id order
+    std::vector<PopulationBlock> populations;
+
+    /// @brief Scratch for routeMatches. Agents with fills this step, where their inboxes sit in inboxFills, and the fills
+    std::vector<AgentSlot*> touchedAgents;
+    std::vector<size_t> inboxStart;
+    std::vector<Match> inboxFills;
     tick tickCounter{0};
     long nextTraderId = 1;
     long nextOrderId = 1;
 
+    /// @brief Steps between call auctions. 0 matches continuously
+    unsigned long auctionInterval = 0;
+
     /// @brief Asset - Matcher
-    std::unordered_map<std::string, Matcher> orderMatchers;
+    std::unordered_map<Symbol, Matcher> orderMatchers;
+
+    struct OpenOrder{
+        Matcher* book;
+        Symbol asset;
+    };
+
+    /// @brief Order id - book of every order on a book, so a cancel goes straight to its book.
+    /// Entries are added when placement is confirmed and dropped on fill or cancel
+    std::unordered_map<long, OpenOrder> orderBooks;
+
+    /// @brief Asset - orders placed this step. Submitted to each matcher as one batch
+    std::unordered_map<Symbol, std::vector<Order>> pendingOrders;
     InMemoryNotifier notifier{};
 
     Observation latestObservation;
 
-    void cancelOrderWithAllMatchers(long doomedOrderId);
-    void addMatcherIfNeeded(const std::string& asset);
+    /// @brief Asset - matcher version latestObservation was built from
+    std::unordered_map<Symbol, unsigned long> observedVersions;
+
+    /// @brief Price levels per side observed for each asset, unless overridden in assetDepthLevels. 0 skips depth
+    size_t depthLevels = defaultDepthLevels;
+    std::unordered_map<Symbol, size_t> assetDepthLevels;
+
+    /// @brief Reused by observe, so reading a book's depth doesn't allocate
+    Depth depthBuffer;
+
+    /// @brief Evaluates policies when more than one thread is asked for
+    std::unique_ptr<ThreadPool> policyPool;
+    /// @brief This step's action for each agent, by agent index
+    std::vector<Action> actions;
+
+    /// @brief Records every call on the matchers while a trace is running
+    std::unique_ptr<TraceWriter> trace;
+
+    void cancelOrder(long doomedOrderId);
+    void addMatcherIfNeeded(Symbol asset);
     void routeMatches(std::vector<Match>& matches);
+    void routeCanceledOrders(std::vector<Order>& canceledOrders);
+    void routePlacedOrders(std::vector<Order>& placedOrders);
+    /// @brief Index slot of a trader id, nullptr if no agent was ever added with it
+    AgentSlot* findSlot(long traderId);
+    Agent* findAgent(long traderId);
+    /// @brief Population holding a trader id, with member set to its index
+    PopulationBlock* findPopulation(long traderId, size_t& member);
+    void routeToPopulation(long traderId, std::vector<MemberOrderId> PopulationBlock::* events, long ordId);
+    /// @brief Hand each population the events collected in one of its lists, then clear them
+    template<typename Event>
+    void flushPopulationEvents(std::vector<Event> PopulationBlock::* events,
+        void (Population::* callback)(const std::vector<Event>&, tick));
+    /// @brief Bring latestObservation up to date. Only books that changed since the last call are read again
     void observe();
+    void evaluatePolicies();
+    void applyAction(Agent& agent, const Action& action);
+    void applyPopulationActions(PopulationBlock& block);
 
     public:
         ABM() = default;
         void simStep();
+
+        /// @brief Collect orders for a number of steps, then cross every book in one auction.
+        /// DAY orders expire after each auction instead of after each step. 0 switches back to continuous matching
+        void setAuctionInterval(unsigned long steps);
+
+        /// @brief Evaluate agent and population policies on this many threads, counting the caller. 1 evaluates them in turn.
+        /// Every policy sees the observation from the start of the step and actions of agents and population members
+        /// are applied in trader id order, so a simulation runs the same for any thread count
+        void setPolicyThreads(size_t numThreads);
+        size_t getPolicyThreads() const { return policyPool ? policyPool->size() : 1; }
+
+        /// @brief Price levels per side agents see in each asset's depth. 0 leaves depth out and keeps only spreads.
+        /// Assets given their own setting keep it
+        void setDepthLevels(size_t levels);
+        /// @brief Depth levels for one asset, overriding the setting for all assets.
+        /// E.g. 0 for everything and a few levels for the assets agents actually read
+        void setDepthLevels(Symbol asset, size_t levels);
+
         long addAgent(std::unique_ptr<Agent> newAgent);
         void removeAgents(AgentSelector& agentSelector);
+
+        /// @brief Add every member of a population. Populations live as long as the ABM
+        /// @return trader id of the first member. The rest follow in member order
+        long addPopulation(std::unique_ptr<Population> population);
         
+        /// @brief Record every order, cancel, auction, expiry and step end sent to the matchers from now on into a trace
+        /// file, see TraceReplay. Throws std::runtime_error if the file can't be opened. Replaces a running trace.
+        /// Replays start from empty books, so a trace can only start while no orders rest on the books:
+        /// throws std::logic_error otherwise. Start it before the first step, or once every order is filled or canceled
+        void startTrace(const std::string& path);
+        /// @brief Finish the trace file. Also done when the ABM is destroyed
+        void stopTrace();
+        bool isTracing() const { return trace != nullptr; }
+
         size_t getNumAgents() const { return agents.size(); }
+        size_t getNumPopulationMembers() const;
+        size_t getNumOpenOrders() const { return orderBooks.size(); }
         const Observation& getLatestObservation() {return latestObservation; };
 
 };
\ No newline at end of file
@@ -74,13 +74,8 @@ Producer::Producer(long traderId_, std::string asset_, unsigned short preferedPr
 {}
 
 Action Producer::policy(const Observation& observation) {
-    auto it = observation.assetSpreads.find(asset);
-
     // If asset spread is missing, trust a new orderbook is created for new asset
-    Spread assetSpread = Spread();
-    if (it != observation.assetSpreads.end()) {
-        assetSpread = it->second;
-    }
+    Spread assetSpread = observation.spread(asset);
 
     // Reduce production if bids are missing
     if(assetSpread.bidsMissing){
@@ -95,7 +90,8 @@ Action Producer::policy(const Observation& observation) {
             --qtyPerTick;
     }
 
-    Order order(asset, SELL, MARKET, 0, qtyPerTick);
+    // Whatever isn't sold this step is dropped rather than left on the book
+    Order order(asset, SELL, MARKET, 0, qtyPerTick, 0, DAY);
     return Action{order};
 }
 
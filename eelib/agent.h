@@ -2,19 +2,11 @@
 
 #include "matcher.h"
 #include "match.h"
+#include "observation.h"
 #include <string>
 #include <functional>
-#include <map>
 #include "tick.h"
 
-struct Observation{
-    tick time;
-
-    /// @brief asset - Spread
-    std::map<std::string, Spread> assetSpreads;
-    std::map<std::string, Depth> assetOrderDepths;
-};
-
 struct Action{
     bool placeOrder = false;
     Order order;
@@ -48,9 +40,19 @@ class Agent{
         Agent(long);
         virtual ~Agent() = default;
 
+        /// @brief Next action, given the market at the start of the step. Policies of different agents may run
+        /// at the same time (see ABM::setPolicyThreads), so a policy should only change its own agent
         virtual Action policy(const Observation& observation);
 
         virtual void matchFound(const Match& match, tick now){};
+
+        /// @brief Every fill this agent took part in during a step, in match order. A match between two of
+        /// the agent's own orders shows up twice. Hands each fill to matchFound unless overridden
+        virtual void matchesFound(MatchSpan fills, tick now){
+            for(const Match& match : fills){
+                matchFound(match, now);
+            }
+        };
         virtual void orderPlaced(long orderId, tick now){};
         virtual void orderCanceled(long orderId, tick now){};
 
@@ -61,7 +63,7 @@ class Agent{
 class Consumer : public Agent{
 
     private:
-        std::string asset;
+        Symbol asset;
         tick lastConsumed;
         long lastPlacedOrderId;
         unsigned short maxPrice;
@@ -80,7 +82,7 @@ class Consumer : public Agent{
 };
 
 class Producer : public Agent{
-    std::string asset;
+    Symbol asset;
     unsigned short preferedPrice;
     unsigned int qtyPerTick = 1;
 
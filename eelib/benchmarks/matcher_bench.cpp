@@ -0,0 +1,321 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "matcher.h"
+#include "matcher_impl.h"
+#include "workload.h"
+
+/*
+Per operation costs of a single book.
+
+Every case runs on the map and the ladder book, against books of 1k to 10M resting orders.
+Cases that use up the book put back what they took with the timer paused, so each
+iteration sees a book of the same shape. Run with --benchmark_format=json or
+--benchmark_out=<file> --benchmark_out_format=json to keep the numbers.
+*/
+
+namespace {
+
+/// @brief Drops everything, so the cost measured is the book's own
+struct DiscardNotifier final{
+    void notifyOrderPlaced(const Order& order){}
+    void notifyOrderPlacementFailed(const Order& order, std::string reason){}
+    void notifyOrderMatched(const Match& match){ benchmark::DoNotOptimize(match.qty); }
+    void notifyOrderCanceled(const Order& order){}
+};
+
+constexpr unsigned short midPrice = 30000;
+/// @brief Price levels each side of a resting book is spread over
+constexpr long bookLevels = 1000;
+/// @brief Prices below this are never used by resting books, so there is always room for new levels
+constexpr unsigned short freePrices = 20000;
+
+template<typename Levels>
+struct Book{
+    DiscardNotifier notifier;
+    BasicMatcher<Levels, DiscardNotifier> matcher{&notifier};
+    long nextOrdId = 1;
+
+    long add(Side side, OrdType type, unsigned short price, unsigned int qty, unsigned short stopPrice = 0){
+        Order order(Symbol(), side, type, price, qty, stopPrice);
+        order.ordId = nextOrdId++;
+        matcher.addOrder(order);
+        return order.ordId;
+    }
+
+    /// @brief Rest numOrders limits, half bids below the mid and half asks above it, round robin over bookLevels prices
+    void rest(long numOrders){
+        for(long i = 0; i < numOrders; ++i){
+            unsigned short offset = (unsigned short)(1 + (i / 2) % bookLevels);
+            if(i % 2 == 0){
+                add(BUY, LIMIT, midPrice - offset, 1);
+            }
+            else{
+                add(SELL, LIMIT, midPrice + offset, 1);
+            }
+        }
+    }
+};
+
+void restingBookSizes(benchmark::internal::Benchmark* bench){
+    for(long size : {1000L, 100000L, 10000000L}){
+        bench->Arg(size);
+    }
+}
+
+template<typename Levels>
+void BM_LimitInsertExistingLevel(benchmark::State& state){
+    Book<Levels> book;
+    book.rest(state.range(0));
+
+    std::vector<long> inserted;
+    for(auto _ : state){
+        inserted.push_back(book.add(BUY, LIMIT, midPrice - 5, 1));
+
+        // Keep the book from growing
+        if(inserted.size() == 4096){
+            state.PauseTiming();
+            for(long ordId : inserted) book.matcher.cancelOrder(ordId);
+            inserted.clear();
+            state.ResumeTiming();
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+template<typename Levels>
+void BM_LimitInsertNewLevel(benchmark::State& state){
+    Book<Levels> book;
+    book.rest(state.range(0));
+
+    std::vector<long> inserted;
+    for(auto _ : state){
+        // Every insert opens a price nobody rests at
+        unsigned short price = (unsigned short)(freePrices - inserted.size());
+        inserted.push_back(book.add(BUY, LIMIT, price, 1));
+
+        if(inserted.size() == 4096){
+            state.PauseTiming();
+            for(long ordId : inserted) book.matcher.cancelOrder(ordId);
+            inserted.clear();
+            state.ResumeTiming();
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+enum QueuePosition { FRONT, MIDDLE, BACK };
+
+/// @brief Cancel orders at one position of a single deep level. Canceled orders are put back at the end of the queue
+template<typename Levels, QueuePosition position>
+void BM_CancelInDeepLevel(benchmark::State& state){
+    Book<Levels> book;
+
+    // The level's queue in time order, split in two halves so the middle is cheap to reach
+    std::deque<long> head;
+    std::deque<long> tail;
+    for(long i = 0; i < state.range(0); ++i){
+        (i < state.range(0) / 2 ? head : tail).push_back(book.add(BUY, LIMIT, midPrice, 1));
+    }
+
+    const size_t batch = std::max<size_t>(1, std::min<size_t>(1024, state.range(0) / 4));
+    std::vector<long> doomed;
+    size_t next = batch;
+    for(auto _ : state){
+        if(next == batch){
+            state.PauseTiming();
+            for(size_t i = 0; i < doomed.size(); ++i){
+                tail.push_back(book.add(BUY, LIMIT, midPrice, 1));
+            }
+            while(head.size() < tail.size()){
+                head.push_back(tail.front());
+                tail.pop_front();
+            }
+
+            // Take the next batch in time order
+            doomed.clear();
+            for(size_t i = 0; i < batch; ++i){
+                switch(position){
+                    case FRONT:
+                        doomed.push_back(head.front());
+                        head.pop_front();
+                        break;
+                    case BACK:
+                        doomed.insert(doomed.begin(), tail.back());
+                        tail.pop_back();
+                        break;
+                    case MIDDLE:
+                        if(i % 2 == 0){
+                            doomed.insert(doomed.begin(), head.back());
+                            head.pop_back();
+                        }
+                        else{
+                            doomed.push_back(tail.front());
+                            tail.pop_front();
+                        }
+                        break;
+                }
+            }
+            next = 0;
+            state.ResumeTiming();
+        }
+
+        // Front cancels oldest first and back newest first, so each one is at the edge of the queue
+        long ordId = position == BACK ? doomed[batch - 1 - next] : doomed[next];
+        benchmark::DoNotOptimize(book.matcher.cancelOrder(ordId));
+        ++next;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+/// @brief A market buy that empties range(1) ask levels. Args: resting orders, levels swept
+template<typename Levels>
+void BM_MarketSweep(benchmark::State& state){
+    Book<Levels> book;
+    book.rest(state.range(0));
+
+    const long levelsSwept = state.range(1);
+    const long ordersPerLevel = std::max<long>(1, state.range(0) / 2 / bookLevels);
+    for(auto _ : state){
+        book.add(BUY, MARKET, 0, (unsigned int)(levelsSwept * ordersPerLevel));
+
+        state.PauseTiming();
+        for(long level = 1; level <= levelsSwept; ++level){
+            for(long i = 0; i < ordersPerLevel; ++i){
+                book.add(SELL, LIMIT, midPrice + level, 1);
+            }
+        }
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * levelsSwept * ordersPerLevel);
+}
+
+/// @brief A market sell takes the only bid at the touch, releasing range(1) sell stops into the bids behind it.
+/// Args: resting orders, stops triggered
+template<typename Levels>
+void BM_StopTrigger(benchmark::State& state){
+    Book<Levels> book;
+    book.rest(state.range(0));
+
+    const unsigned short touch = midPrice;
+    const long numStops = state.range(1);
+    auto setUp = [&]{
+        book.add(BUY, LIMIT, touch, 1);
+        for(long i = 0; i < numStops; ++i){
+            book.add(SELL, STOP, 0, 1, touch);
+            // Replaces what the stop will take from the next bid level
+            book.add(BUY, LIMIT, midPrice - 1, 1);
+        }
+    };
+
+    setUp();
+    for(auto _ : state){
+        book.add(SELL, MARKET, 0, 1);
+
+        state.PauseTiming();
+        setUp();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * numStops);
+}
+
+template<typename Levels>
+void BM_GetSpread(benchmark::State& state){
+    Book<Levels> book;
+    book.rest(state.range(0));
+
+    for(auto _ : state){
+        benchmark::DoNotOptimize(book.matcher.getSpread());
+    }
+}
+
+/// @brief Args: resting orders, levels per side
+template<typename Levels>
+void BM_GetDepth(benchmark::State& state){
+    Book<Levels> book;
+    book.rest(state.range(0));
+
+    Depth depth;
+    for(auto _ : state){
+        book.matcher.getDepth(depth, (size_t)state.range(1));
+        benchmark::DoNotOptimize(depth.bidBins.data());
+    }
+}
+
+template<typename Levels>
+void BM_GetOrderCounts(benchmark::State& state){
+    Book<Levels> book;
+    book.rest(state.range(0));
+
+    for(auto _ : state){
+        benchmark::DoNotOptimize(book.matcher.getOrderCounts());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/// @brief Replays a seeded scenario into one book per symbol. Books are rebuilt with the timer paused
+/// once the commands run out, so every run sees the same flow. Arg: seed
+template<typename Levels, WorkloadScenario scenario>
+void BM_Workload(benchmark::State& state){
+    WorkloadGenerator workload(scenario, (std::uint64_t)state.range(0));
+    const std::vector<EngineCommand> commands = workload.generate(1000000);
+
+    std::vector<std::unique_ptr<Book<Levels>>> books;
+    auto reset = [&]{
+        books.clear();
+        for(size_t i = 0; i < workload.symbols().size(); ++i){
+            books.push_back(std::make_unique<Book<Levels>>());
+        }
+    };
+
+    reset();
+    size_t next = 0;
+    for(auto _ : state){
+        if(next == commands.size()){
+            state.PauseTiming();
+            reset();
+            next = 0;
+            state.ResumeTiming();
+        }
+        const EngineCommand& command = commands[next++];
+        benchmark::DoNotOptimize(applyCommand(books[workload.symbolIndex(command.order.asset)]->matcher, command));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void sweepArgs(benchmark::internal::Benchmark* bench){
+    bench->ArgsProduct({{1000, 100000, 10000000}, {1, 10, 100}});
+}
+
+void stopArgs(benchmark::internal::Benchmark* bench){
+    bench->ArgsProduct({{1000, 100000, 10000000}, {1, 64}});
+}
+
+void depthArgs(benchmark::internal::Benchmark* bench){
+    bench->ArgsProduct({{1000, 100000, 10000000}, {5, (long)defaultDepthLevels}});
+}
+
+}
+
+#define EELIB_BOOK_BENCHMARKS(Levels) \
+    BENCHMARK_TEMPLATE(BM_LimitInsertExistingLevel, Levels)->Apply(restingBookSizes); \
+    BENCHMARK_TEMPLATE(BM_LimitInsertNewLevel, Levels)->Apply(restingBookSizes); \
+    BENCHMARK_TEMPLATE(BM_CancelInDeepLevel, Levels, FRONT)->Apply(restingBookSizes); \
+    BENCHMARK_TEMPLATE(BM_CancelInDeepLevel, Levels, MIDDLE)->Apply(restingBookSizes); \
+    BENCHMARK_TEMPLATE(BM_CancelInDeepLevel, Levels, BACK)->Apply(restingBookSizes); \
+    BENCHMARK_TEMPLATE(BM_MarketSweep, Levels)->Apply(sweepArgs); \
+    BENCHMARK_TEMPLATE(BM_StopTrigger, Levels)->Apply(stopArgs); \
+    BENCHMARK_TEMPLATE(BM_GetSpread, Levels)->Apply(restingBookSizes); \
+    BENCHMARK_TEMPLATE(BM_GetDepth, Levels)->Apply(depthArgs); \
+    BENCHMARK_TEMPLATE(BM_GetOrderCounts, Levels)->Apply(restingBookSizes); \
+    BENCHMARK_TEMPLATE(BM_Workload, Levels, MARKET_MAKING)->Arg(1); \
+    BENCHMARK_TEMPLATE(BM_Workload, Levels, MOMENTUM_BURSTS)->Arg(1); \
+    BENCHMARK_TEMPLATE(BM_Workload, Levels, DEEP_BOOK)->Arg(1); \
+    BENCHMARK_TEMPLATE(BM_Workload, Levels, ZIPF_SYMBOLS)->Arg(1);
+
+EELIB_BOOK_BENCHMARKS(MapPriceLevels)
+EELIB_BOOK_BENCHMARKS(LadderPriceLevels)
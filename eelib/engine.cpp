@@ -0,0 +1,212 @@
+#include "engine.h"
+#include "matcher_impl.h"
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+
+/// @brief Owns the books for its symbols and runs them on its own thread
+class ShardedEngine::Worker{
+
+    /// @brief Publishes matcher output onto the worker's output ring, tagged with the command being handled
+    class OutputNotifier final{
+        Worker& worker;
+
+        void publish(NotifierEventType type, const Order* order, const Match* match){
+            EngineEvent event{};
+            event.commandSeq = worker.currentSeq;
+            event.event.type = type;
+            if(order) event.event.order = *order;
+            if(match) event.event.match = *match;
+            worker.outbox.publish(event);
+        }
+
+        public:
+            OutputNotifier(Worker& worker_) : worker(worker_){}
+
+            void notifyOrderPlaced(const Order& order){
+                publish(ORDER_PLACED, &order, nullptr);
+            }
+            void notifyOrderPlacementFailed(const Order& order, std::string reason){
+                publish(ORDER_PLACEMENT_FAILED, &order, nullptr);
+            }
+            void notifyOrderMatched(const Match& match){
+                publish(ORDER_MATCHED, nullptr, &match);
+            }
+            void notifyOrderCanceled(const Order& order){
+                publish(ORDER_CANCELED, &order, nullptr);
+            }
+    };
+
+    using Book = BasicMatcher<MapPriceLevels, OutputNotifier>;
+
+    OutputNotifier notifier{*this};
+    std::unordered_map<Symbol, Book> books;
+    bool trackLatency;
+    unsigned long currentSeq = 0;
+    std::thread thread;
+
+    Book& bookFor(Symbol asset){
+        auto it = books.find(asset);
+        if(it == books.end()){
+            it = books.emplace(asset, Book(&notifier)).first;
+            it->second.setLatencyTracking(trackLatency);
+        }
+        return it->second;
+    }
+
+    void handle(const EngineCommand& command){
+        currentSeq = command.seq;
+
+        switch(command.type){
+            case ADD_ORDER:
+            {
+                Order order = command.order;
+                bookFor(command.order.asset).addOrder(order);
+                break;
+            }
+            case CANCEL_ORDER:
+            {
+                // Only orders create books, so cancels for symbols never traded can't pile up empty ones
+                auto it = books.find(command.order.asset);
+                if(it != books.end() && it->second.cancelOrder(command.order.ordId)){
+                    notifier.notifyOrderCanceled(command.order);
+                }
+                break;
+            }
+        }
+
+        // Output for this command is published before this store, so a submitter that sees it can collect everything
+        handledThrough.store(command.seq, std::memory_order_release);
+    }
+
+    void run(){
+        while(inbox.process(inboxConsumer, [&](const EngineCommand& command){ handle(command); })){}
+    }
+
+    public:
+        EventBus<EngineCommand> inbox;
+        EventBus<EngineEvent> outbox;
+        size_t inboxConsumer;
+        size_t outboxConsumer;
+
+        /// @brief Submission number of the last command this worker finished
+        std::atomic<unsigned long> handledThrough{0};
+
+        /// @brief Submitter side only. Submission number of the last command sent here
+        unsigned long lastSent = 0;
+
+        Worker(size_t queueCapacity, WaitStrategy waitStrategy, bool trackLatency_) :
+            trackLatency(trackLatency_),
+            inbox(queueCapacity, waitStrategy),
+            outbox(queueCapacity, waitStrategy)
+        {
+            inboxConsumer = inbox.subscribe();
+            outboxConsumer = outbox.subscribe();
+            thread = std::thread([this]{ run(); });
+        }
+
+        /// @brief Only while the worker is idle, after handledThrough has caught up
+        void addLatenciesTo(OrderLatencies& total) const{
+            for(auto& it : books){
+                if(const OrderLatencies* bookLatencies = it.second.getLatencies()){
+                    total.merge(*bookLatencies);
+                }
+            }
+        }
+
+        /// @brief Only while the worker is idle, after handledThrough has caught up
+        size_t numBooks() const { return books.size(); }
+
+        ~Worker(){
+            inbox.halt();
+            outbox.halt();
+            thread.join();
+        }
+};
+
+ShardedEngine::ShardedEngine(size_t numWorkers, size_t queueCapacity, WaitStrategy waitStrategy, bool trackLatency){
+    if(numWorkers == 0){
+        numWorkers = 1;
+    }
+    for(size_t w = 0; w < numWorkers; ++w){
+        workers.push_back(std::make_unique<Worker>(queueCapacity, waitStrategy, trackLatency));
+    }
+    staged.resize(numWorkers);
+    stagedRead.resize(numWorkers, 0);
+}
+
+ShardedEngine::~ShardedEngine() = default;
+
+unsigned long ShardedEngine::addOrder(const Order& order){
+    EngineCommand command{};
+    command.type = ADD_ORDER;
+    command.seq = ++lastSeq;
+    command.order = order;
+    submit(command);
+    return command.seq;
+}
+
+unsigned long ShardedEngine::cancelOrder(Symbol asset, long ordId){
+    EngineCommand command{};
+    command.type = CANCEL_ORDER;
+    command.seq = ++lastSeq;
+    command.order.asset = asset;
+    command.order.ordId = ordId;
+    submit(command);
+    return command.seq;
+}
+
+void ShardedEngine::submit(const EngineCommand& command){
+    Worker& worker = *workers[workerFor(command.order.asset)];
+
+    // A worker with a full output ring stops taking commands, so empty the output rings while waiting
+    while(!worker.inbox.tryPublish(command)){
+        collectOutputs();
+        std::this_thread::yield();
+    }
+    worker.lastSent = command.seq;
+}
+
+OrderLatencies ShardedEngine::latencies(){
+    waitForWorkers();
+
+    OrderLatencies total;
+    for(auto& worker : workers){
+        worker->addLatenciesTo(total);
+    }
+    return total;
+}
+
+size_t ShardedEngine::numBooks(){
+    waitForWorkers();
+
+    size_t total = 0;
+    for(auto& worker : workers){
+        total += worker->numBooks();
+    }
+    return total;
+}
+
+void ShardedEngine::collectOutputs(){
+    for(size_t w = 0; w < workers.size(); ++w){
+        Worker& worker = *workers[w];
+        worker.outbox.poll(worker.outboxConsumer, [&](const EngineEvent& event){
+            staged[w].push_back(event);
+        });
+    }
+}
+
+void ShardedEngine::waitForWorkers(){
+    while(true){
+        bool caughtUp = true;
+        for(auto& worker : workers){
+            if(worker->handledThrough.load(std::memory_order_acquire) < worker->lastSent){
+                caughtUp = false;
+            }
+        }
+
+        collectOutputs();
+        if(caughtUp) return;
+        std::this_thread::yield();
+    }
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "order.h"
+#include "symbol.h"
+#include "eventbus.h"
+#include "latency.h"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+enum EngineCommandType : unsigned char {
+    ADD_ORDER = 1,
+    CANCEL_ORDER = 2
+};
+
+/// @brief An order or cancel on its way to a worker
+struct EngineCommand{
+    EngineCommandType type;
+    /// @brief Engine wide submission number. Starts at 1
+    unsigned long seq;
+    /// @brief The order to add. For cancels only ordId and asset are set
+    Order order;
+};
+
+/// @brief Matcher output tagged with the command that caused it
+struct EngineEvent{
+    unsigned long commandSeq;
+    NotifierEvent event;
+};
+
+static_assert(std::is_trivially_copyable<EngineCommand>::value, "EngineCommand should be plain data");
+static_assert(std::is_trivially_copyable<EngineEvent>::value, "EngineEvent should be plain data");
+
+/*
+Matching engine that spreads symbols over worker threads.
+
+Every symbol belongs to exactly one worker, picked from its id, and only that worker touches its book.
+Orders and cancels are numbered as they are submitted and reach each worker through its own
+single producer, single consumer ring. Workers write their output to their own ring, and drain merges
+the rings back together in submission order. So the output stream is the same for any number of workers
+and any thread timing, and every symbol sees exactly the sequence of events a lone Matcher would produce.
+
+Submitting and draining happen on one thread.
+*/
+class ShardedEngine{
+    class Worker;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    unsigned long lastSeq = 0;
+
+    /// @brief Output collected from each worker's ring, waiting to be merged
+    std::vector<std::vector<EngineEvent>> staged;
+    std::vector<size_t> stagedRead;
+
+    void submit(const EngineCommand& command);
+
+    /// @brief Move everything workers have published so far into staged
+    void collectOutputs();
+
+    /// @brief Collect until every worker has handled every command submitted so far
+    void waitForWorkers();
+
+    public:
+        /// @param numWorkers number of worker threads, at least 1
+        /// @param queueCapacity slots in each worker's command and output rings
+        /// @param trackLatency time every order and cancel on the books, see latencies
+        ShardedEngine(size_t numWorkers, size_t queueCapacity = 1 << 16, WaitStrategy waitStrategy = YIELD,
+            bool trackLatency = false);
+        ~ShardedEngine();
+
+        ShardedEngine(const ShardedEngine&) = delete;
+        ShardedEngine& operator=(const ShardedEngine&) = delete;
+
+        size_t numWorkers() const { return workers.size(); }
+        size_t workerFor(Symbol asset) const { return asset.id() % workers.size(); }
+
+        /// @brief Queue an order for its symbol's worker. The order's ordId must be unique per symbol
+        /// @return submission number of the order
+        unsigned long addOrder(const Order& order);
+
+        /// @brief Queue a cancel. A successful cancel shows up as an ORDER_CANCELED event carrying just the id and asset
+        /// @return submission number of the cancel
+        unsigned long cancelOrder(Symbol asset, long ordId);
+
+        /// @brief Wait for the workers to catch up, then add up the latencies of every book.
+        /// Empty unless the engine was made with trackLatency. Output collected while waiting is kept for drain
+        OrderLatencies latencies();
+
+        /// @brief Wait for the workers to catch up, then count the books they hold: one per symbol that was sent an order
+        size_t numBooks();
+
+        /// @brief Wait for the workers to catch up, then hand every new event to handler(const EngineEvent&)
+        /// ordered by submission number, and by the order the matcher produced them within one submission
+        template<typename Handler>
+        void drain(Handler&& handler){
+            waitForWorkers();
+
+            while(true){
+                size_t next = staged.size();
+                for(size_t w = 0; w < staged.size(); ++w){
+                    if(stagedRead[w] == staged[w].size()) continue;
+                    if(next == staged.size() ||
+                        staged[w][stagedRead[w]].commandSeq < staged[next][stagedRead[next]].commandSeq){
+                        next = w;
+                    }
+                }
+                if(next == staged.size()) break;
+
+                // A command only ever reaches one worker, so all of its events are together
+                unsigned long commandSeq = staged[next][stagedRead[next]].commandSeq;
+                while(stagedRead[next] < staged[next].size() && staged[next][stagedRead[next]].commandSeq == commandSeq){
+                    handler(staged[next][stagedRead[next]++]);
+                }
+            }
+
+            for(size_t w = 0; w < staged.size(); ++w){
+                staged[w].clear();
+                stagedRead[w] = 0;
+            }
+        }
+};
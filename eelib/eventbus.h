@@ -0,0 +1,277 @@
+#pragma once
+
+#include "order.h"
+#include "match.h"
+#include "notifier.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <chrono>
+#include <vector>
+
+/// @brief What a thread does while it waits on the bus
+enum WaitStrategy : unsigned char {
+
+    /// @brief spin on the cursor. Lowest latency, burns a core
+    BUSY_SPIN = 1,
+
+    /// @brief spin, giving the core away between checks
+    YIELD = 2,
+
+    /// @brief sleep on a condition variable. Publishers only touch it when someone is asleep
+    BLOCK = 3
+};
+
+/*
+Disruptor style ring buffer with one publisher and any number of consumers.
+
+Every slot is allocated up front. The publisher claims the next sequence, writes the slot and
+moves its cursor forward; it never locks or allocates. Each consumer has its own cursor and sees every
+event in publish order. The publisher can't lap the slowest consumer, so a consumer that falls a whole
+ring behind holds the publisher back until it catches up.
+
+Consumers subscribe before publishing starts. Each consumer is driven by one thread.
+*/
+template<typename T>
+class EventBus{
+    public:
+        using Sequence = std::int64_t;
+
+    private:
+        /// @brief Cursor on its own cache line so threads don't fight over neighbours
+        struct alignas(64) PaddedSequence{
+            std::atomic<Sequence> value{-1};
+        };
+
+        std::vector<T> slots;
+        Sequence mask;
+        WaitStrategy waitStrategy;
+
+        PaddedSequence published;
+        std::vector<std::unique_ptr<PaddedSequence>> consumers;
+
+        /// @brief Publisher side only. Next sequence to claim, and the slowest consumer as of the last check
+        Sequence nextToClaim = 0;
+        Sequence cachedSlowest = -1;
+
+        std::atomic<bool> halted{false};
+        std::atomic<int> sleepers{0};
+        std::mutex sleepMutex;
+        std::condition_variable wakeUp;
+
+        Sequence slowestConsumer() const {
+            Sequence slowest = published.value.load(std::memory_order_relaxed);
+            for(auto& consumer : consumers){
+                slowest = std::min(slowest, consumer->value.load(std::memory_order_acquire));
+            }
+            return slowest;
+        }
+
+        /// @brief Wait until ready returns true, or the bus is halted
+        template<typename Ready>
+        bool waitUntil(Ready&& ready){
+            while(!ready()){
+                if(halted.load(std::memory_order_acquire)) return false;
+
+                switch(waitStrategy){
+                    case BUSY_SPIN:
+                        break;
+                    case YIELD:
+                        std::this_thread::yield();
+                        break;
+                    case BLOCK:
+                    {
+                        // Announce the sleep before checking again. The fence pairs with the one in wakeSleepers:
+                        // either the waker sees the sleeper, or the check sees what was published
+                        std::unique_lock<std::mutex> lock(sleepMutex);
+                        sleepers.fetch_add(1, std::memory_order_seq_cst);
+                        std::atomic_thread_fence(std::memory_order_seq_cst);
+                        wakeUp.wait_for(lock, std::chrono::milliseconds(1), [&]{
+                            return halted.load(std::memory_order_acquire) || ready();
+                        });
+                        sleepers.fetch_sub(1, std::memory_order_relaxed);
+                        break;
+                    }
+                }
+            }
+            return true;
+        }
+
+        /// @brief Call after moving a cursor. Taking the lock means a sleeper is either still before its check,
+        /// and will see the move, or already waiting, and gets the notify
+        void wakeSleepers(){
+            if(waitStrategy != BLOCK) return;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if(sleepers.load(std::memory_order_seq_cst) > 0){
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                wakeUp.notify_all();
+            }
+        }
+
+    public:
+        /// @param capacity number of slots. Rounded up to a power of two
+        EventBus(size_t capacity, WaitStrategy waitStrategy_ = YIELD) : waitStrategy(waitStrategy_){
+            size_t size = 1;
+            while(size < capacity){
+                size <<= 1;
+            }
+            slots.resize(size);
+            mask = (Sequence)size - 1;
+        }
+
+        EventBus(const EventBus&) = delete;
+        EventBus& operator=(const EventBus&) = delete;
+
+        size_t capacity() const { return slots.size(); }
+
+        /// @brief Add a consumer. It sees events published from now on. Not safe once publishing has started
+        /// @return consumer id for poll and process
+        size_t subscribe(){
+            consumers.push_back(std::make_unique<PaddedSequence>());
+            consumers.back()->value.store(published.value.load(std::memory_order_acquire), std::memory_order_release);
+            cachedSlowest = -1;
+            return consumers.size() - 1;
+        }
+
+        /// @brief Copy an event into the next slot. Waits while the slowest consumer is a full ring behind
+        /// @return false if the bus was halted while waiting
+        bool publish(const T& event){
+            Sequence sequence = nextToClaim;
+            Sequence wrapPoint = sequence - (Sequence)slots.size();
+
+            if(wrapPoint > cachedSlowest){
+                bool ok = waitUntil([&]{
+                    cachedSlowest = slowestConsumer();
+                    return wrapPoint <= cachedSlowest;
+                });
+                if(!ok) return false;
+            }
+
+            slots[sequence & mask] = event;
+            ++nextToClaim;
+            published.value.store(sequence, std::memory_order_release);
+            wakeSleepers();
+            return true;
+        }
+
+        /// @brief Publish without waiting
+        /// @return false, and publishes nothing, if the slowest consumer is a full ring behind
+        bool tryPublish(const T& event){
+            Sequence sequence = nextToClaim;
+            Sequence wrapPoint = sequence - (Sequence)slots.size();
+
+            if(wrapPoint > cachedSlowest){
+                cachedSlowest = slowestConsumer();
+                if(wrapPoint > cachedSlowest) return false;
+            }
+
+            slots[sequence & mask] = event;
+            ++nextToClaim;
+            published.value.store(sequence, std::memory_order_release);
+            wakeSleepers();
+            return true;
+        }
+
+        /// @brief Hand every event the consumer hasn't seen yet to handler(const T&). Doesn't wait
+        /// @return number of events handled
+        template<typename Handler>
+        size_t poll(size_t consumer, Handler&& handler){
+            PaddedSequence& cursor = *consumers[consumer];
+            Sequence seen = cursor.value.load(std::memory_order_relaxed);
+            Sequence available = published.value.load(std::memory_order_acquire);
+
+            for(Sequence sequence = seen + 1; sequence <= available; ++sequence){
+                handler(slots[sequence & mask]);
+            }
+
+            if(available > seen){
+                // Slots are free for the publisher once the cursor moves past them
+                cursor.value.store(available, std::memory_order_release);
+                wakeSleepers();
+            }
+            return (size_t)(available > seen ? available - seen : 0);
+        }
+
+        /// @brief Wait for at least one new event, then handle everything available
+        /// @return false once the bus is halted and this consumer has seen every event
+        template<typename Handler>
+        bool process(size_t consumer, Handler&& handler){
+            PaddedSequence& cursor = *consumers[consumer];
+            Sequence seen = cursor.value.load(std::memory_order_relaxed);
+
+            waitUntil([&]{ return published.value.load(std::memory_order_acquire) > seen; });
+            return poll(consumer, handler) > 0 || !halted.load(std::memory_order_acquire);
+        }
+
+        /// @brief Stop waiting publishers and consumers. Events already published can still be polled
+        void halt(){
+            halted.store(true, std::memory_order_release);
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            wakeUp.notify_all();
+        }
+
+        bool isHalted() const { return halted.load(std::memory_order_acquire); }
+
+        /// @brief Sequence of the last published event, -1 before the first
+        Sequence cursor() const { return published.value.load(std::memory_order_acquire); }
+};
+
+enum NotifierEventType : unsigned char {
+    ORDER_PLACED = 1,
+    ORDER_PLACEMENT_FAILED = 2,
+    ORDER_MATCHED = 3,
+    ORDER_CANCELED = 4
+};
+
+/// @brief One INotifier call as it travels on the bus. order is set for placements and cancels, match for matches.
+/// Placement failure reasons stay behind so the slot stays plain data
+struct NotifierEvent{
+    NotifierEventType type;
+    Order order;
+    Match match;
+};
+
+static_assert(std::is_trivially_copyable<NotifierEvent>::value, "NotifierEvent should be plain data");
+
+/// @brief Publishes matcher output onto an event bus, so consumers run on their own threads
+class BusNotifier final: public INotifier{
+    EventBus<NotifierEvent>& bus;
+    size_t dropped_ = 0;
+
+    void publish(NotifierEventType type, const Order* order, const Match* match){
+        NotifierEvent event{};
+        event.type = type;
+        if(order) event.order = *order;
+        if(match) event.match = *match;
+        if(!bus.publish(event)){
+            ++dropped_;
+        }
+    }
+
+    public:
+        BusNotifier(EventBus<NotifierEvent>& bus_) : bus(bus_){}
+
+        /// @brief Events that never made it onto the bus because it was halted while the ring was full.
+        /// The matcher can't be told mid match, so check this after halting
+        size_t dropped() const { return dropped_; }
+
+        void notifyOrderPlaced(const Order& order){
+            publish(ORDER_PLACED, &order, nullptr);
+        }
+        void notifyOrderPlacementFailed(const Order& order, std::string reason){
+            publish(ORDER_PLACEMENT_FAILED, &order, nullptr);
+        }
+        void notifyOrderMatched(const Match& match){
+            publish(ORDER_MATCHED, nullptr, &match);
+        }
+        void notifyOrderCanceled(const Order& order){
+            publish(ORDER_CANCELED, &order, nullptr);
+        }
+};
@@ -0,0 +1,57 @@
+#include "latency.h"
+#include <algorithm>
+#include <cmath>
+
+std::uint64_t LatencyHistogram::highestIn(size_t bucket){
+    if(bucket < 32) return bucket;
+    size_t magnitude = (bucket - 32) / 16;
+    size_t sub = (bucket - 32) % 16;
+    unsigned int shift = (unsigned int)magnitude + 1;
+    return ((16 + sub + 1) << shift) - 1;
+}
+
+std::uint64_t LatencyHistogram::percentile(double percentile) const{
+    if(total == 0) return 0;
+
+    // Rank of the value asked for, counting from 1. The slack keeps 99.9% of 1000 at rank 999, not 1000
+    double clamped = std::min(100.0, std::max(0.0, percentile));
+    double exactRank = clamped / 100.0 * (double)total;
+    std::uint64_t rank = std::max<std::uint64_t>(1, (std::uint64_t)std::ceil(exactRank - 1e-9 * exactRank));
+
+    std::uint64_t seen = 0;
+    for(size_t bucket = 0; bucket < numBuckets; ++bucket){
+        seen += counts[bucket];
+        if(seen >= rank){
+            return std::min(highestIn(bucket), max_);
+        }
+    }
+    return max_;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other){
+    for(size_t bucket = 0; bucket < numBuckets; ++bucket){
+        counts[bucket] += other.counts[bucket];
+    }
+    total += other.total;
+    sum += other.sum;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+}
+
+void LatencyHistogram::reset(){
+    *this = LatencyHistogram();
+}
+
+void OrderLatencies::merge(const OrderLatencies& other){
+    for(size_t type = 0; type < numTypes; ++type){
+        adds[type].merge(other.adds[type]);
+        cancels[type].merge(other.cancels[type]);
+    }
+}
+
+void OrderLatencies::reset(){
+    for(size_t type = 0; type < numTypes; ++type){
+        adds[type].reset();
+        cancels[type].reset();
+    }
+}
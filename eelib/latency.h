@@ -0,0 +1,93 @@
+#pragma once
+
+#include "order.h"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/*
+HDR style histogram of latencies in nanoseconds.
+
+Values below 32 get a bucket each. Above that, every power of two is split into 16 buckets, so a value
+lands in a bucket at most 1/16th (about 6%) wider than itself, from nanoseconds up to centuries.
+Recording is a few instructions into a fixed array; nothing allocates.
+*/
+class LatencyHistogram{
+    public:
+        static constexpr size_t numBuckets = 32 + (64 - 5) * 16;
+
+    private:
+        std::array<std::uint64_t, numBuckets> counts{};
+        std::uint64_t total = 0;
+        std::uint64_t sum = 0;
+        std::uint64_t min_ = UINT64_MAX;
+        std::uint64_t max_ = 0;
+
+        static size_t bucketOf(std::uint64_t nanos){
+            if(nanos < 32) return (size_t)nanos;
+            unsigned int msb = 63 - __builtin_clzll(nanos);
+            unsigned int shift = msb - 4;
+            return 32 + (msb - 5) * 16 + (size_t)((nanos >> shift) - 16);
+        }
+
+        /// @brief Largest value that lands in a bucket
+        static std::uint64_t highestIn(size_t bucket);
+
+    public:
+        void record(std::uint64_t nanos){
+            ++counts[bucketOf(nanos)];
+            ++total;
+            sum += nanos;
+            if(nanos < min_) min_ = nanos;
+            if(nanos > max_) max_ = nanos;
+        }
+
+        /// @brief Latency at or below which percentile % of recorded values fall. 0 when empty.
+        /// Accurate to the bucket width, and never above the largest value recorded
+        std::uint64_t percentile(double percentile) const;
+
+        std::uint64_t count() const { return total; }
+        std::uint64_t min() const { return total ? min_ : 0; }
+        std::uint64_t max() const { return max_; }
+        double mean() const { return total ? (double)sum / (double)total : 0.0; }
+
+        void merge(const LatencyHistogram& other);
+        void reset();
+};
+
+/// @brief Measures from construction to recordInto. Doesn't read the clock unless started
+class LatencyTimer{
+    std::chrono::steady_clock::time_point start;
+    bool running;
+
+    public:
+        explicit LatencyTimer(bool start_) : running(start_){
+            if(running) start = std::chrono::steady_clock::now();
+        }
+
+        void recordInto(LatencyHistogram& histogram){
+            if(!running) return;
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            histogram.record((std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+            running = false;
+        }
+};
+
+/// @brief addOrder and cancelOrder latencies of a book, by order type
+class OrderLatencies{
+    static constexpr size_t numTypes = STOPLIMIT + 1;
+
+    std::array<LatencyHistogram, numTypes> adds;
+    std::array<LatencyHistogram, numTypes> cancels;
+
+    public:
+        LatencyHistogram& add(OrdType type) { return adds[type]; }
+        const LatencyHistogram& add(OrdType type) const { return adds[type]; }
+
+        LatencyHistogram& cancel(OrdType type) { return cancels[type]; }
+        const LatencyHistogram& cancel(OrdType type) const { return cancels[type]; }
+
+        void merge(const OrderLatencies& other);
+        void reset();
+};
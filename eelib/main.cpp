@@ -1,137 +1,135 @@
 #include <iostream>
+#include <iomanip>
 #include "order.h"
 #include "matcher.h"
-#include <random>
+#include "latency.h"
+#include "workload.h"
+#include "trace.h"
 #include <chrono>
-#include <unordered_map>
-#include <type_traits>
-
-void benchmarkMatcher();
-
-int main() {
-    benchmarkMatcher();
-}
-
-
-template <typename Enum, int maxValue>
-Enum random_enum()
-{
-    static_assert(std::is_enum_v<Enum>);
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+template<typename MatcherType>
+void benchmarkMatcher(WorkloadScenario scenario, std::uint64_t seed);
+
+template<typename MatcherType>
+void replayTrace(const std::string& path);
+
+/// Usage: eelib_app [map|ladder] [virtual|static] [market_making|momentum_bursts|deep_book|zipf_symbols] [seed]
+///        eelib_app replay <trace file> [map|ladder]
+int main(int argc, char** argv) {
+    if(argc > 1 && std::string(argv[1]) == "replay"){
+        if(argc < 3){
+            std::cerr << "Usage: eelib_app replay <trace file> [map|ladder]" << std::endl;
+            return 1;
+        }
+        std::string book = argc > 3 ? argv[3] : "map";
+        if(book != "map" && book != "ladder"){
+            std::cerr << "Unknown book type: " << book << " (expected map or ladder)" << std::endl;
+            return 1;
+        }
+        try{
+            book == "map" ? replayTrace<InMemoryMatcher>(argv[2]) : replayTrace<InMemoryLadderMatcher>(argv[2]);
+        }
+        catch(const std::exception& error){
+            std::cerr << error.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
 
-    static std::mt19937 rng{std::random_device{}()};
+    std::string book = argc > 1 ? argv[1] : "map";
+    std::string dispatch = argc > 2 ? argv[2] : "virtual";
+    std::string scenarioArg = argc > 3 ? argv[3] : "momentum_bursts";
+    std::uint64_t seed = 1;
+    if(argc > 4){
+        std::string seedArg = argv[4];
+        try{
+            size_t parsed = 0;
+            // stoull takes a leading minus and wraps it around, and stops at trailing junk
+            if(seedArg.empty() || seedArg[0] == '-') throw std::invalid_argument(seedArg);
+            seed = std::stoull(seedArg, &parsed);
+            if(parsed != seedArg.size()) throw std::invalid_argument(seedArg);
+        }
+        catch(const std::exception&){
+            std::cerr << "Bad seed: " << seedArg << " (expected a non negative integer)" << std::endl;
+            return 1;
+        }
+    }
 
-    using U = std::underlying_type_t<Enum>;
+    if(dispatch != "virtual" && dispatch != "static"){
+        std::cerr << "Unknown notifier dispatch: " << dispatch << " (expected virtual or static)" << std::endl;
+        return 1;
+    }
+    bool isStatic = dispatch == "static";
 
-    constexpr U min = static_cast<U>(1);
-    constexpr U max = static_cast<U>(maxValue);
+    WorkloadScenario scenario;
+    if(!scenarioFromName(scenarioArg, scenario)){
+        std::cerr << "Unknown scenario: " << scenarioArg
+                  << " (expected market_making, momentum_bursts, deep_book or zipf_symbols)" << std::endl;
+        return 1;
+    }
 
-    std::uniform_int_distribution<U> dist(min, max);
-    return static_cast<Enum>(dist(rng));
+    if(book == "map"){
+        isStatic ? benchmarkMatcher<InMemoryMatcher>(scenario, seed) : benchmarkMatcher<Matcher>(scenario, seed);
+    }
+    else if(book == "ladder"){
+        isStatic ? benchmarkMatcher<InMemoryLadderMatcher>(scenario, seed) : benchmarkMatcher<LadderMatcher>(scenario, seed);
+    }
+    else{
+        std::cerr << "Unknown book type: " << book << " (expected map or ladder)" << std::endl;
+        return 1;
+    }
 }
 
-// weighted picker: weights.size() == number of enum values (ordered by underlying value starting at 1)
-template<typename Enum>
-Enum weighted_random_enum(const std::vector<double>& weights) {
-    static_assert(std::is_enum_v<Enum>);
-    static std::mt19937 rng{std::random_device{}()};
-    std::discrete_distribution<size_t> dist(weights.begin(), weights.end());
-    size_t idx = dist(rng);           // idx in [0, weights.size()-1]
-    using U = std::underlying_type_t<Enum>;
-    return static_cast<Enum>(static_cast<U>(idx + 1)); // +1 because enums are assumed to start at 1
-}
 
-class OrderFactory{
-    long int currentIdTimestamp = 1;
-    std::mt19937 gen;
-    std::uniform_int_distribution<long> qtyDistrib;
-    std::normal_distribution<double> priceDistrib;
-    std::normal_distribution<double> stopPriceFactorDistrib;
-    double spreadFactor = 10;
-
-    public:
-        OrderFactory(){
-            qtyDistrib = std::uniform_int_distribution<long>(1, 100);
-            priceDistrib = std::normal_distribution<double>(1000, 100);
-            stopPriceFactorDistrib = std::normal_distribution<double>(30, 10);
-            
-            std::random_device device;
-            gen = std::mt19937(device());
-        }
+/// @brief Percentile table of one histogram, in nanoseconds
+void printLatencies(const std::string& label, const LatencyHistogram& histogram){
+    if(histogram.count() == 0) return;
 
-        Order newOrder(Side side, OrdType type, long qty, long price = 0, long stopPrice = 0){
-            Order o{};
-            o.traderId = currentIdTimestamp;
-            o.ordId = currentIdTimestamp;
-            o.side = side;
-            o.qty = qty;
-            o.price = price;
-            o.stopPrice = stopPrice;
-            o.asset = "TEST";
-            o.type = type;
-            o.ordNum = currentIdTimestamp;
-
-            ++currentIdTimestamp;
-            return o;
-        }
-
-        Order randomOrder(){
-            Side side = random_enum<Side, 2>();
-            OrdType ordType = weighted_random_enum<OrdType>(
-                {
-                    1.0, // MARKET
-                    1.01, // LIMIT
-                    0.0, // STOP
-                    0.0, // STOPLIMIT
-                }
-            );
-            long qty = qtyDistrib(gen);
-            double price = priceDistrib(gen);
-            double stopPriceFactor = stopPriceFactorDistrib(gen);
-            double stopPrice;
-
-
-            switch(side){
-                case BUY:
-                    price = price - spreadFactor;
-                    stopPrice = price + stopPriceFactor;
-                    break;
-                case SELL:
-                    price = price + spreadFactor; 
-                    stopPrice = price - stopPriceFactor;
-                    break;
-            }
-            
-            return newOrder(side, ordType, qty, price, stopPrice);
-        }
-};
-    
+    std::cout << label << " (" << histogram.count() << " orders, mean " << (std::uint64_t)histogram.mean() << " ns)\n";
+    const std::pair<const char*, double> rows[] = {
+        {"min", 0.0}, {"p50", 50.0}, {"p75", 75.0}, {"p90", 90.0},
+        {"p99", 99.0}, {"p99.9", 99.9}, {"p99.99", 99.99}, {"max", 100.0}
+    };
+    for(auto& row : rows){
+        std::cout << "  " << std::setw(8) << std::left << row.first << std::right
+                  << std::setw(12) << histogram.percentile(row.second) << " ns\n";
+    }
+}
 
-void benchmarkMatcher(){
+template<typename MatcherType>
+void benchmarkMatcher(WorkloadScenario scenario, std::uint64_t seed){
 
     InMemoryNotifier notifier;
-    Matcher matcher{&notifier};
-    OrderFactory ordFactory{};
-
-    int numOrders = 5000000;
-    std::vector<Order> orders{};
+    WorkloadGenerator workload(scenario, seed);
 
-    for(int i = 0; i <= numOrders; i++){
-        orders.push_back(ordFactory.randomOrder());
+    // One book per symbol. Progress is shown for the first, which gets the most flow
+    std::vector<std::unique_ptr<MatcherType>> matchers;
+    for(size_t i = 0; i < workload.symbols().size(); ++i){
+        matchers.push_back(std::make_unique<MatcherType>(&notifier));
+        matchers.back()->setLatencyTracking(true);
     }
+    MatcherType& matcher = *matchers.front();
+
+    size_t numCommands = 5000000;
+    std::vector<EngineCommand> commands = workload.generate(numCommands);
 
-    std::cout << "Generated orders. Running benchmark..." << std::endl;
+    std::cout << "Generated " << numCommands << " " << scenarioName(scenario) << " commands with seed " << seed
+              << ". Running benchmark..." << std::endl;
     size_t processed = 0;
     auto last_print = std::chrono::steady_clock::now();
 
-    for (auto &order : orders) {
-        matcher.addOrder(order);
+    for (auto &command : commands) {
+        applyCommand(*matchers[workload.symbolIndex(command.order.asset)], command);
         ++processed;
 
         auto now = std::chrono::steady_clock::now();
         if (now - last_print >= std::chrono::seconds(1)) {
             auto counts = matcher.getOrderCounts();
             auto spread = matcher.getSpread();
-            std::cout << processed << " orders processed | "
+            std::cout << processed << " commands processed | "
                       << "MARKET:" << counts[MARKET]
                       << " LIMIT:" << counts[LIMIT]
                       << " STOP:" << counts[STOP]
@@ -160,5 +158,44 @@ void benchmarkMatcher(){
     std::cout << "Done!" << std::endl;
     std::cout << "Matches Found: " << notifier.matches.size() << std::endl;
     std::cout << "Orders Rejected: " << notifier.placementFailedOrders.size() << std::endl;
+    std::cout << "Orders Canceled: " << notifier.canceledOrders.size() << std::endl;
+
+    OrderLatencies latencies;
+    for(auto& book : matchers){
+        latencies.merge(*book->getLatencies());
+    }
+    printLatencies("addOrder MARKET", latencies.add(MARKET));
+    printLatencies("addOrder LIMIT", latencies.add(LIMIT));
+    printLatencies("addOrder STOP", latencies.add(STOP));
+    printLatencies("addOrder STOPLIMIT", latencies.add(STOPLIMIT));
+    printLatencies("cancelOrder MARKET", latencies.cancel(MARKET));
+    printLatencies("cancelOrder LIMIT", latencies.cancel(LIMIT));
+    printLatencies("cancelOrder STOP", latencies.cancel(STOP));
+    printLatencies("cancelOrder STOPLIMIT", latencies.cancel(STOPLIMIT));
 
-};
\ No newline at end of file
+};
+
+/// @brief Stream a recorded ABM run into one book per asset as fast as the books take it
+template<typename MatcherType>
+void replayTrace(const std::string& path){
+    TraceReplay replay(path);
+
+    InMemoryNotifier notifier;
+    std::vector<MatcherType> books;
+    books.reserve(replay.assets().size());
+    for(size_t i = 0; i < replay.assets().size(); ++i){
+        books.emplace_back(&notifier);
+    }
+
+    std::cout << "Replaying " << replay.size() << " records over " << replay.assets().size() << " assets..." << std::endl;
+    auto start = std::chrono::steady_clock::now();
+    TraceReplayStats stats = replay.replay(books);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Done in " << seconds << " s" << std::endl;
+    std::cout << "Steps: " << stats.ticks << " | Orders: " << stats.orders << " in " << stats.batches << " batches"
+              << " | Cancels: " << stats.cancels << std::endl;
+    std::cout << "Orders + cancels per second: " << (std::uint64_t)((stats.orders + stats.cancels) / seconds) << std::endl;
+    std::cout << "Matches Found: " << notifier.matches.size() << std::endl;
+    std::cout << "Orders Rejected: " << notifier.placementFailedOrders.size() << std::endl;
+}
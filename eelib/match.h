@@ -1,28 +1,43 @@
 #pragma once
 
-#include <vector>
+#include <cstddef>
+#include <type_traits>
 #include "order.h"
-#include <stdexcept>
 
-// TODO time of match might be important for message ordering down stream
+/// @brief One side of a match
+struct MatchParty{
+    long ordId;
+    long traderId;
+};
+
+/// @brief A fill between a buy and a sell order. Plain data, so it can be copied straight into a buffer
 struct Match{
-    Order buyer;
-    Order seller;
-    long int qty;
+    MatchParty buyer;
+    MatchParty seller;
+    /// @brief Position of this match among all matches from the same book. Starts at 1
+    unsigned long seq;
+    unsigned int qty;
+    Symbol asset;
+    /// @brief Price the qty traded at
+    unsigned short price;
+    /// @brief Buy or sell side of the order that took liquidity. In an auction, the side of the newer order
+    Side aggressor;
+    /// @brief Set when this match fills the rest of the order, taking it off the book
+    bool buyerFilled;
+    bool sellerFilled;
+};
+
+static_assert(std::is_trivially_copyable<Match>::value, "Match should be plain data");
+static_assert(sizeof(Match) <= 64, "Match should fit in a cache line");
 
-    public:
-        Match(const Order& ord1, const Order& ord2, long int qty)
-        {
-            if (ord1.side == ord2.side) { std::logic_error("Can't match orders on the same side!"); }
-            if (ord1.side == BUY){
-                this->buyer = ord1;
-                this->seller = ord2;
-            }
-            else{
-                this->buyer = ord2;
-                this->seller = ord1;
-            }
+/// @brief Read only view of consecutive matches owned by someone else
+struct MatchSpan{
+    const Match* first = nullptr;
+    size_t count = 0;
 
-            this->qty = qty;
-        }
+    const Match* begin() const { return first; }
+    const Match* end() const { return first + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const Match& operator[](size_t i) const { return first[i]; }
 };
@@ -3,8 +3,10 @@
 #include "order.h"
 #include "match.h"
 #include "notifier.h"
+#include "pricelevels.h"
+#include "latency.h"
+#include <memory>
 #include <vector>
-#include <set>
 #include <queue>
 #include <map>
 #include <stdexcept>
@@ -12,7 +14,10 @@
 
 struct PriceBin{
     unsigned short price = 0;
+    /// @brief Unfilled qty at this price and every better price
     unsigned int totalQty = 0;
+    /// @brief Number of orders resting at this price
+    unsigned int numOrders = 0;
 };
 
 struct Depth{
@@ -20,6 +25,26 @@ struct Depth{
     std::vector<PriceBin> askBins;
 };
 
+/// @brief Price levels per side getDepth reports unless asked for another number
+constexpr size_t defaultDepthLevels = 300;
+
+/// @brief How a matcher crosses orders
+enum MatchingMode : unsigned char {
+
+    /// @brief market orders fill against resting limits as they arrive
+    CONTINUOUS = 1,
+
+    /// @brief orders collect on the book until uncross is called, then trade at a single clearing price
+    AUCTION = 2
+};
+
+/// @brief Outcome of an auction
+struct AuctionResult{
+    bool crossed = false;
+    unsigned short price = 0;
+    unsigned int volume = 0;
+};
+
 struct TypeFilled{
     bool market = false;
     bool limit = false;
@@ -32,78 +57,195 @@ struct TypeFilled{
 };
 
 /// @brief Processes orders for a single symbol
-class Matcher{
+/// @tparam Levels price level container for each side of the book. See pricelevels.h
+/// @tparam Notifier receives placements, rejections, matches and cancels. Any type with INotifier's methods works.
+/// INotifier dispatches through virtual calls; a concrete final notifier lets the compiler inline the calls into the matching loop
+template<typename Levels, typename Notifier = INotifier>
+class BasicMatcher{
 
     private:
         unsigned long lastOrdNum = 0;
+        unsigned long lastMatchSeq = 0;
+
+        /// @brief Bumped whenever an order joins, fills or leaves the book
+        unsigned long version = 0;
+
+        MatchingMode mode = CONTINUOUS;
         
-        // TODO: Research tree balancing and its effect on performance here
         //Order FIFO queues for different prices
-        std::map<unsigned short, std::vector<Order>> sellLimits;
-        std::map<unsigned short, std::vector<Order>> buyLimits;
+        Levels sellLimits;
+        Levels buyLimits;
+
+        OrderQueue marketOrders;
+
+        /// @brief Untriggered stops and stop limits, keyed by stop price. They aren't on the book and don't count in the spread
+        Levels sellStops;
+        Levels buyStops;
+
+        /// @brief Ids of DAY orders placed since the last expireDayOrders. Some may have filled or been canceled since
+        std::vector<long> dayOrders;
+
+        /// @brief Spread the stop index was last checked against
+        Spread stopSpread;
 
-        std::vector<Order> marketOrders;
-        std::set<long> canceledOrderIds;
+        /// @brief Storage for the nodes of every queue on the book
+        OrderPool pool;
+
+        /// @brief Every order on the book, by order id. Untriggered stops and stop limits are in the stop index,
+        /// market and triggered stop orders are in marketOrders, limits and triggered stop limits are in the level at their price
+        std::unordered_map<long, OrderRef> orderLocations;
+
+        /// @brief Best bid and ask. Kept up to date as orders are added, filled and canceled. Parked stop limits don't count
+        Spread spread;
+
+        /// @brief addOrder and cancelOrder latencies. nullptr unless tracking is on, so untracked books never read the clock
+        std::unique_ptr<OrderLatencies> latencies;
 
         bool validateOrder(const Order& order);
 
-        bool isCanceled(long ordId);
+        /// @brief Validate, number and insert an order without matching it
+        /// @return false if the order was rejected
+        bool placeOrder(Order& order);
+
+        void pushBackLimitOrder(OrderRef ref);
 
-        void pushBackLimitOrder(const Order& order);
+        /// @brief Unlink an order from whichever queue holds it and release its node. Keeps levels and the spread up to date
+        void removeFromBook(OrderRef ref);
+
+        /// @brief Take an order off the book on the matcher's own initiative and report it to the notifier
+        void cancelRemainder(OrderRef ref);
+
+        /// @brief Build a match from two orders on the book and send it to the notifier
+        void notifyMatch(OrderRef buyer, OrderRef seller, unsigned int qty, unsigned short price, Side aggressor);
+
+        /// @brief Price and volume the next auction would trade at. Costs O(levels)
+        AuctionResult findClearingPrice();
+
+        /// @brief Trade the auction volume at the clearing price
+        void executeAuction(const AuctionResult& result);
+
+        /// @brief True if the opposite side of the book holds at least qty
+        bool liquidityAvailable(Side side, unsigned int qty);
+
+        /// @brief Hold a stop or stop limit in the stop index until the touch reaches its stop price
+        void parkStop(OrderRef ref);
+
+        /// @brief Move stops crossed by the touch since the last check to the market queue or the book.
+        /// Triggered stop limits can move the touch again, so this repeats until the touch settles.
+        /// Stops are only checked when the touch moves, never when they are placed
+        void releaseTriggeredStops();
+
+        /// @brief Move every order parked at the given stop prices, lowest stop price first when buying and highest when selling
+        void releaseStops(Levels& stops, const std::vector<unsigned short>& stopPrices);
+
+        /// @brief Recompute the highest bid from the first buy level with live orders
+        void refreshBestBid();
+
+        /// @brief Recompute the lowest ask from the first sell level with live orders
+        void refreshBestAsk();
 
         /// @brief Try to find matches for all orders on the book
         void matchOrders();
 
         /// @brief Tries to fill a buy market order as much as possible. Updates fill properties in matched orders. Spread is also updated
         /// @param order 
-        /// @param spread
         /// @return true if filled completely
-        bool tryFillBuyMarket(Order& order, Spread& spread);
+        bool tryFillBuyMarket(OrderRef order);
 
         /// @brief Tries to fill a sell market order as much as possible. Updates fill properties in matched orders.  Spread is also updated
         /// @param order 
-        /// @param spread
         /// @return true if filled completely
-        bool tryFillSellMarket(Order& order, Spread& spread);
+        bool tryFillSellMarket(OrderRef order);
 
-        /// @brief Remove limit orders from book at given price
+        /// @brief Remove empty price levels from the book
         /// @param limitPricesToRemove 
         /// @param side 
         void removeLimitsByPrice(std::vector<unsigned short> limitPricesToRemove, Side side);
 
-        /// @brief Matches a market order with limits sorted from the oldest to newest
+        /// @brief Matches a market order with limits sorted from the oldest to newest. Keeps the level's live totals up to date
         /// @param marketOrd 
         /// @param limitOrds 
         /// @return true if market order is filled
-        bool matchLimits(Order& marketOrd, const Spread& spread, 
-            std::vector<Order>& limitOrds);
+        bool matchLimits(OrderRef marketOrd, PriceLevel& limitOrds);
 
 
         /// @brief Matches a market order an a limit. returns the type that was completely filled
         /// @param market 
         /// @param limit 
         /// @return 
-        TypeFilled matchMarketAndLimit(Order& market, Order& limit);
+        TypeFilled matchMarketAndLimit(OrderRef market, OrderRef limit);
 
-        Matcher() = default;
+        BasicMatcher() = default;
     public:
-        INotifier* notifier;
+        Notifier* notifier;
 
-        Matcher(INotifier* notif): notifier(notif){
-            Matcher();
-        }
+        BasicMatcher(Notifier* notif): notifier(notif){}
 
         /// @brief Add order to the book
         /// @param order 
         void addOrder(Order& order, bool thenMatch = true);
 
-        void cancelOrder(long ordId);
+        /// @brief Add a batch of orders, then run a single matching pass.
+        /// Orders are numbered in batch order. The whole batch rests before matching starts, so a market
+        /// in the batch can fill against a limit that comes after it. Markets fill in batch order, behind markets already queued
+        /// @param orders ordNum is set on every accepted order
+        void addOrders(std::vector<Order>& orders);
+
+        /// @brief Remove an order from the book
+        /// @param ordId 
+        /// @return false if the order isn't on the book (unknown, filled or already canceled)
+        bool cancelOrder(long ordId);
+
+        /// @brief Switch between continuous matching and call auctions. Orders collected in auction mode
+        /// wait for the next uncross or, after switching back, the next continuous matching pass
+        void setMode(MatchingMode newMode) { mode = newMode; }
+        MatchingMode getMode() const { return mode; }
+
+        /// @brief Cross the book at the price that executes the most qty. Ties go to the smallest
+        /// imbalance, then to the highest price if buyers are left over and the lowest price otherwise.
+        /// Everyone trades at that one price. Market orders fill first, then limits by price and time.
+        /// Afterwards crossed stops are released for the next auction and IOC leftovers are canceled
+        AuctionResult uncross();
+
+        /// @brief Cancel every DAY order still on the book. Each one is reported through notifyOrderCanceled
+        void expireDayOrders();
         
         /// @brief Add all orders in the book to a vector provided by reference. They are NOT sorted by time.
         /// @param orders 
         void dumpOrdersTo(std::vector<Order>& orders);
 
+        /// @brief Time every addOrder and cancelOrder, by order type. Turning tracking off drops what was recorded.
+        /// addOrders batches aren't timed
+        void setLatencyTracking(bool on);
+        /// @brief Latencies recorded since tracking was turned on, or nullptr when it is off
+        const OrderLatencies* getLatencies() const { return latencies.get(); }
+
+        /// @brief Changes whenever an order joins, fills or leaves the book, so views built from
+        /// getSpread and getDepth only need rebuilding when this moves
+        unsigned long getVersion() const { return version; }
+
+        /// @brief Best bid and ask with the live qty at each. Constant time
         const Spread getSpread();
+        /// @brief Cumulative depth built from the level totals. Costs O(levels), not O(orders)
         const Depth getDepth();
+        /// @brief Cumulative depth of the best maxLevels prices on each side, written over depth.
+        /// Reuses depth's buffers, and only walks the levels it reports
+        void getDepth(Depth& depth, size_t maxLevels = defaultDepthLevels);
         const std::unordered_map<OrdType, int> getOrderCounts();
-};
\ No newline at end of file
+};
+
+/// @brief Matcher with tree based price levels
+using Matcher = BasicMatcher<MapPriceLevels>;
+
+/// @brief Matcher with flat array price levels
+using LadderMatcher = BasicMatcher<LadderPriceLevels>;
+
+/// @brief Matchers that call InMemoryNotifier directly, without virtual dispatch
+using InMemoryMatcher = BasicMatcher<MapPriceLevels, InMemoryNotifier>;
+using InMemoryLadderMatcher = BasicMatcher<LadderPriceLevels, InMemoryNotifier>;
+
+// Defined in matcher_impl.h and instantiated in matcher.cpp
+extern template class BasicMatcher<MapPriceLevels, INotifier>;
+extern template class BasicMatcher<LadderPriceLevels, INotifier>;
+extern template class BasicMatcher<MapPriceLevels, InMemoryNotifier>;
+extern template class BasicMatcher<LadderPriceLevels, InMemoryNotifier>;
@@ -0,0 +1,832 @@
+#pragma once
+
+// Definitions for BasicMatcher. Include this instead of matcher.h to instantiate a matcher
+// with a notifier type that matcher.cpp doesn't already provide
+
+#include "order.h"
+#include "matcher.h"
+#include <vector>
+#include <map>
+#include <stdexcept>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <algorithm>
+
+template<typename Levels, typename Notifier>
+const Spread BasicMatcher<Levels, Notifier>::getSpread(){
+    return spread;
+}
+
+template<typename Levels, typename Notifier>
+void BasicMatcher<Levels, Notifier>::refreshBestBid(){
+    spread.bidsMissing = true;
+    spread.highestBid = 0;
+    spread.highestBidQty = 0;
+
+    buyLimits.descending([&](unsigned short price, PriceLevel& level){
+        if(level.numOrders == 0) return true;
+        spread.bidsMissing = false;
+        spread.highestBid = price;
+        spread.highestBidQty = level.openQty;
+        return false;
+    });
+}
+
+template<typename Levels, typename Notifier>
+void BasicMatcher<Levels, Notifier>::refreshBestAsk(){
+    spread.asksMissing = true;
+    spread.lowestAsk = 0;
+    spread.lowestAskQty = 0;
+
+    sellLimits.ascending([&](unsigned short price, PriceLevel& level){
+        if(level.numOrders == 0) return true;
+        spread.asksMissing = false;
+        spread.lowestAsk = price;
+        spread.lowestAskQty = level.openQty;
+        return false;
+    });
+}
+
+template<typename Levels, typename Notifier>
+const Depth BasicMatcher<Levels, Notifier>::getDepth(){
+    Depth depth;
+    getDepth(depth);
+    return depth;
+}
+
+template<typename Levels, typename Notifier>
+void BasicMatcher<Levels, Notifier>::getDepth(Depth& depth, size_t maxLevels){
+    depth.bidBins.clear();
+    depth.askBins.clear();
+    if(maxLevels == 0) return;
+
+    unsigned int cumQty = 0;
+    auto addBin = [&](std::vector<PriceBin>& bins, unsigned short price, const PriceLevel& level){
+        if(bins.size() >= maxLevels) return false;
+        if(level.numOrders == 0) return true;
+        cumQty += level.openQty;
+        bins.push_back(PriceBin{price, cumQty, level.numOrders});
+        return true;
+    };
+
+    // Bids: iterate highest -> lowest, accumulate cumulative qty
+    buyLimits.descending([&](unsigned short price, PriceLevel& level){
+        return addBin(depth.bidBins, price, level);
+    });
+
+    // Asks: iterate lowest -> highest, accumulate cumulative qty
+    cumQty = 0;
+    sellLimits.ascending([&](unsigned short price, PriceLevel& level){
+        return addBin(depth.askBins, price, level);
+    });
+}
+
+template<typename Levels, typename Notifier>
+const std::unordered_map<OrdType, int> BasicMatcher<Levels, Notifier>::getOrderCounts(){
+    std::unordered_map<OrdType, int> counts{
+        {MARKET, 0},
+        {LIMIT, 0},
+        {STOP, 0},
+        {STOPLIMIT, 0}
+    };
+    std::vector<Order> allOrders{};
+    dumpOrdersTo(allOrders);
+
+    for(auto& order : allOrders){
+        counts[order.type]++;
+    }
+    return counts;
+
+}
+
+template<typename Levels, typename Notifier>
+void BasicMatcher<Levels, Notifier>::addOrder(Order& order, bool thenMatch)
+{   
+    LatencyTimer timer(latencies != nullptr);
+
+    // TODO mutex that locks the book until orders are added, and matched
+    if(placeOrder(order) && thenMatch && mode == CONTINUOUS){
+        matchOrders();
+    }
+
+    if(latencies) timer.recordInto(latencies->add(order.type));
+};
+
+template<typename Levels, typename Notifier>
+void BasicMatcher<Levels, Notifier>::addOrders(std::vector<Order>& orders)
+{
+    bool anyPlaced = false;
+    for(auto& order : orders){
+        anyPlaced |= placeOrder(order);
+    }
+
+    if(anyPlaced && mode == CONTINUOUS){
+        matchOrders();
+    }
+}
+
+template<typename Levels, typename Notifier>
+bool BasicMatcher<Levels, Notifier>::placeOrder(Order& order)
+{
+    // Exit early and send notifications if order is invalid
+    if(!validateOrder(order)){
+        return false;
+    }
+
+    order.ordNum = ++lastOrdNum;
+    ++version;
+
+    OrderRef ref = pool.acquire(order);
+    orderLocations[order.ordId] = ref;
+    if(order.tif == DAY){
+        dayOrders.push_back(order.ordId);
+    }
+
+    switch (order.type) {
+        case LIMIT:
+            pushBackLimitOrder(ref);
+            break;
+        case MARKET:
+            marketOrders.pushBack(pool, ref);
+            break;
+        case STOP:
+        case STOPLIMIT:
+            parkStop(ref);
+            break;
+        default:
+            // validateOrder only lets known types through
+            throw std::logic_error("Order type not implemented!");
+    }
+
+    this->notifier->notifyOrderPlaced(order);
+    return true;
+}
+
+template<typename Levels, typename Notifier>
+bool BasicMatcher<Levels, Notifier>::cancelOrder(long ordId){
+    LatencyTimer timer(latencies != nullptr);
+
+    auto found = orderLocations.find(ordId);
+    if(found == orderLocations.end()){
+        return false;
+    }
+    OrderRef ref = found->second;
+    OrdType type = pool.hot(ref).type;
+    orderLocations.erase(found);
+    removeFromBook(ref);
+
+    if(latencies) timer.recordInto(latencies->cancel(type));
+    return true;
+}
+
+template<typename Levels, typename Notifier>
+void BasicMatcher<Levels, Notifier>::setLatencyTracking(bool on){
+    if(!on){
+        latencies.reset();
+    }
+    else if(!latencies){
+        latencies = std::make_unique<OrderLatencies>();
+    }
+}
+
+template<typename Levels, typename Notifier>
+AuctionResult BasicMatcher<Levels, Notifier>::uncross(){
+    AuctionResult result = findClearingPrice();
+    if(result.crossed){
+        executeAuction(result);
+    }
+
+    // IOC orders had their chance
+    OrderRef next = noOrder;
+    for(OrderRef ref = marketOrders.front(); ref != noOrder; ref = next){
+        next = pool.node(ref).next;
+        if(pool.hot(ref).tif == IOC){
+            cancelRemainder(ref);
+        }
+    }
+
+    return result;
+}
+
+template<typename Levels, typename Notifier>
+AuctionResult BasicMatcher<Levels, Notifier>::findClearingPrice(){
+    AuctionResult result;
+
+    struct LevelQty{
+        unsigned short price;
+        unsigned int qty;
+    };
+
+    // Market orders take any price
+    unsigned int buyMarketQty = 0;
+    unsigned int sellMarketQty = 0;
+    for(OrderRef ref = marketOrders.front(); ref != noOrder; ref = pool.node(ref).next){
+        const HotOrder& order = pool.hot(ref);
+        (order.side == BUY ? buyMarketQty : sellMarketQty) += order.unfilled();
+    }
+
+    std::vector<LevelQty> bids{};
+    std::vector<LevelQty> asks{};
+    unsigned int demand = buyMarketQty;
+    buyLimits.ascending([&](unsigned short price, PriceLevel& level){
+        if(level.numOrders > 0){
+            bids.push_back(LevelQty{price, level.openQty});
+            demand += level.openQty;
+        }
+        return true;
+    });
+    sellLimits.ascending([&](unsigned short price, PriceLevel& level){
+        if(level.numOrders > 0) asks.push_back(LevelQty{price, level.openQty});
+        return true;
+    });
+
+    // Walk every limit price from lowest to highest. Demand at a price counts bids at or above it,
+    // supply counts asks at or below it
+    unsigned int supply = sellMarketQty;
+    unsigned int bestSurplus = 0;
+    size_t b = 0;
+    size_t a = 0;
+    while(b < bids.size() || a < asks.size()){
+        unsigned short price = a == asks.size() ? bids[b].price
+            : b == bids.size() ? asks[a].price
+            : std::min(bids[b].price, asks[a].price);
+
+        while(a < asks.size() && asks[a].price <= price){
+            supply += asks[a++].qty;
+        }
+
+        unsigned int volume = std::min(demand, supply);
+        unsigned int surplus = std::max(demand, supply) - volume;
+        if(volume > 0){
+            // On a tie, buyers left over at this price push the price up to it. Otherwise the lower price stays
+            bool buyersLeftOver = demand > supply;
+            if(volume > result.volume || (volume == result.volume && surplus < bestSurplus)){
+                result.crossed = true;
+                result.volume = volume;
+                result.price = price;
+                bestSurplus = surplus;
+            }
+            else if(volume == result.volume && surplus == bestSurplus && buyersLeftOver){
+                result.price = price;
+            }
+        }
+
+        while(b < bids.size() && bids[b].price <= price){
+            demand -= bids[b++].qty;
+        }
+    }
+
+    return result;
+}
+
+template<typename Levels, typename Notifier>
+void BasicMatcher<Levels, Notifier>::executeAuction(const AuctionResult& result){
+    // Everyone who trades, in priority order. Stop once there is enough qty to cover the volume
+    std::vector<OrderRef> buyers{};
+    std::vector<OrderRef> sellers{};
+    unsigned int buyQty = 0;
+    unsigned int sellQty = 0;
+
+    for(OrderRef ref = marketOrders.front(); ref != noOrder; ref = pool.node(ref).next){
+        const HotOrder& order = pool.hot(ref);
+        if(order.side == BUY && buyQty < result.volume){
+            buyers.push_back(ref);
+            buyQty += order.unfilled();
+        }
+        else if(order.side == SELL && sellQty < result.volume){
+            sellers.push_back(ref);
+            sellQty += order.unfilled();
+        }
+    }
+
+    auto collect = [&](std::vector<OrderRef>& refs, unsigned int& qty, PriceLevel& level){
+        for(OrderRef ref = level.orders.front(); ref != noOrder && qty < result.volume; ref = pool.node(ref).next){
+            refs.push_back(ref);
+            qty += pool.hot(ref).unfilled();
+        }
+        return qty < result.volume;
+    };
+    buyLimits.descending([&](unsigned short price, PriceLevel& level){
+        return price >= result.price && collect(buyers, buyQty, level);
+    });
+    sellLimits.ascending([&](unsigned short price, PriceLevel& level){
+        return price <= result.price && collect(sellers, sellQty, level);
+    });
+
+    // Fill a single order and take it off the book once it's done
+    auto fill = [&](OrderRef ref, unsigned int qty){
+        HotOrder& order = pool.hot(ref);
+        order.fill += qty;
+        if(order.type == LIMIT || order.type == STOPLIMIT){
+            Levels& levels = order.side == SELL ? sellLimits : buyLimits;
+            levels.find(order.price)->openQty -= qty;
+        }
+    };
+    auto removeIfFilled = [&](OrderRef ref){
+        const HotOrder& order = pool.hot(ref);
+        if(order.unfilled() > 0){
+            return false;
+        }
+        orderLocations.erase(order.ordId);
+        removeFromBook(ref);
+        return true;
+    };
+
+    unsigned int remaining = result.volume;
+    size_t i = 0;
+    size_t j = 0;
+    while(remaining > 0){
+        OrderRef buyer = buyers[i];
+        OrderRef seller = sellers[j];
+        unsigned int qty = std::min({pool.hot(buyer).unfilled(), pool.hot(seller).unfilled(), remaining});
+
+        fill(buyer, qty);
+        fill(seller, qty);
+        remaining -= qty;
+
+        Side aggressor = pool.hot(buyer).ordNum > pool.hot(seller).ordNum ? BUY : SELL;
+        notifyMatch(buyer, seller, qty, result.price, aggressor);
+
+        if(removeIfFilled(buyer)) ++i;
+        if(removeIfFilled(seller)) ++j;
+    }
+
+    refreshBestBid();
+    refreshBestAsk();
+    releaseTriggeredStops();
+}
+
+template<typename Levels, typename Notifier>
+void BasicMatcher<Levels, Notifier>::expireDayOrders(){
+    for(long ordId : dayOrders){
+        auto found = orderLocations.find(ordId);
+        if(found != orderLocations.end()){
+            cancelRemainder(found->second);
+        }
+    }
+    dayOrders.clear();
+}
+
+template<typename Levels, typename Notifier>
+void BasicMatcher<Levels, Notifier>::cancelRemainder(OrderRef ref){
+    Order order = pool.toOrder(ref);
+    orderLocations.erase(order.ordId);
+    removeFromBook(ref);
+    this->notifier->notifyOrderCanceled(order);
+}
+
+template<typename Levels, typename Notifier>
+void BasicMatcher<Levels, Notifier>::removeFromBook(OrderRef ref){
+    ++version;
+    const HotOrder& order = pool.hot(ref);
+
+    // Market and triggered stop orders don't affect the spread
+    if(order.type == MARKET || (order.type == STOP && order.triggered)){
+        marketOrders.remove(pool, ref);
+        pool.release(ref);
+        return;
+    }
+
+    bool parked = order.type != LIMIT && !order.triggered;
+    Levels& levels = parked ? (order.side == SELL ? sellStops : buyStops)
+                            : (order.side == SELL ? sellLimits : buyLimits);
+    Side side = order.side;
+    unsigned short price = parked ? order.stopPrice : order.price;
+
+    PriceLevel& level = *levels.find(price);
+    level.openQty -= order.unfilled();
+    --level.numOrders;
+    level.orders.remove(pool, ref);
+    pool.release(ref);
+
+    if(level.orders.empty()){
+        levels.erase(price);
+    }
+
+    // Parked stops aren't in the spread
+    if(parked){
+        return;
+    }
+
+    switch(side){
+        case BUY:
+            if(price == spread.highestBid) refreshBestBid();
+            break;
+        case SELL:
+            if(price == spread.lowestAsk) refreshBestAsk();
+            break;
+    }
+}
+
+template<typename Levels, typename Notifier>
+void BasicMatcher<Levels, Notifier>::dumpOrdersTo(std::vector<Order>& orders){
+    
+    auto dumpQueue = [&](const OrderQueue& queue){
+        for(OrderRef ref = queue.front(); ref != noOrder; ref = pool.node(ref).next){
+            orders.push_back(pool.toOrder(ref));
+        }
+    };
+
+    // Add market and triggered stop orders
+    dumpQueue(marketOrders);
+
+    auto dumpLevel = [&](unsigned short price, PriceLevel& book){
+        dumpQueue(book.orders);
+        return true;
+    };
+
+    // Add untriggered stops and stop limits
+    buyStops.ascending(dumpLevel);
+    sellStops.ascending(dumpLevel);
+
+    // Add buy limits and stop limits
+    buyLimits.ascending(dumpLevel);
+
+    // Add sell limits and stop limits
+    sellLimits.ascending(dumpLevel);
+}
+
+template<typename Levels, typename Notifier>
+void BasicMatcher<Levels, Notifier>::pushBackLimitOrder(OrderRef ref){
+    const HotOrder& order = pool.hot(ref);
+
+    Levels& levels = order.side == SELL ? sellLimits : buyLimits;
+    PriceLevel& level = levels.getOrCreate(order.price);
+    level.orders.pushBack(pool, ref);
+    ++level.numOrders;
+    level.openQty += order.unfilled();
+
+    // Move the touch if this order improves it
+    switch(order.side)
+    {
+        case BUY:
+            if(spread.bidsMissing || order.price >= spread.highestBid){
+                spread.bidsMissing = false;
+                spread.highestBid = order.price;
+                spread.highestBidQty = level.openQty;
+            }
+            break;
+        case SELL:
+            if(spread.asksMissing || order.price <= spread.lowestAsk){
+                spread.asksMissing = false;
+                spread.lowestAsk = order.price;
+                spread.lowestAskQty = level.openQty;
+            }
+            break;
+    }
+}
+
+template<typename Levels, typename Notifier>
+void BasicMatcher<Levels, Notifier>::parkStop(OrderRef ref){
+    const HotOrder& order = pool.hot(ref);
+
+    Levels& stops = order.side == SELL ? sellStops : buyStops;
+    PriceLevel& level = stops.getOrCreate(order.stopPrice);
+    level.orders.pushBack(pool, ref);
+    ++level.numOrders;
+    level.openQty += order.unfilled();
+}
+
+template<typename Levels, typename Notifier>
+void BasicMatcher<Levels, Notifier>::releaseTriggeredStops(){
+    std::vector<unsigned short> triggered{};
+
+    while(true){
+        bool askMoved = spread.asksMissing != stopSpread.asksMissing || spread.lowestAsk != stopSpread.lowestAsk;
+        bool bidMoved = spread.bidsMissing != stopSpread.bidsMissing || spread.highestBid != stopSpread.highestBid;
+        if(!askMoved && !bidMoved){
+            return;
+        }
+        stopSpread = spread;
+
+        // Buy stops trigger once the lowest ask is at or above the stop price
+        if(askMoved && !spread.asksMissing && !buyStops.empty()){
+            triggered.clear();
+            buyStops.ascending([&](unsigned short stopPrice, PriceLevel& level){
+                if(stopPrice > spread.lowestAsk) return false;
+                triggered.push_back(stopPrice);
+                return true;
+            });
+            releaseStops(buyStops, triggered);
+        }
+
+        // Sell stops trigger once the highest bid is at or below the stop price
+        if(bidMoved && !spread.bidsMissing && !sellStops.empty()){
+            triggered.clear();
+            sellStops.descending([&](unsigned short stopPrice, PriceLevel& level){
+                if(stopPrice < spread.highestBid) return false;
+                triggered.push_back(stopPrice);
+                return true;
+            });
+            releaseStops(sellStops, triggered);
+        }
+    }
+}
+
+template<typename Levels, typename Notifier>
+void BasicMatcher<Levels, Notifier>::releaseStops(Levels& stops, const std::vector<unsigned short>& stopPrices){
+    for(auto stopPrice : stopPrices){
+        PriceLevel& level = *stops.find(stopPrice);
+
+        OrderRef next = noOrder;
+        for(OrderRef ref = level.orders.front(); ref != noOrder; ref = next){
+            next = pool.node(ref).next;
+            HotOrder& order = pool.hot(ref);
+            order.triggered = true;
+
+            if(order.type == STOP){
+                marketOrders.pushBack(pool, ref);
+            }
+            else{
+                pushBackLimitOrder(ref);
+            }
+        }
+
+        stops.erase(stopPrice);
+    }
+}
+
+template<typename Levels, typename Notifier>
+bool BasicMatcher<Levels, Notifier>::validateOrder(const Order& order){
+
+    // Enums from outside the matcher, e.g. a trace or a network message, can hold any value
+    if(order.side != BUY && order.side != SELL){
+        this->notifier->notifyOrderPlacementFailed(order, "Unknown order side");
+        return false;
+    }
+    if(order.type < MARKET || order.type > STOPLIMIT){
+        this->notifier->notifyOrderPlacementFailed(order, "Order type not implemented");
+        return false;
+    }
+    if(order.tif != DAY && order.tif != GTC && order.tif != IOC && order.tif != FOK){
+        this->notifier->notifyOrderPlacementFailed(order, "Unknown time in force");
+        return false;
+    }
+
+    // Prevent orders with 0 or negative prices or quantities from being added to the book
+    if(order.qty < 1){
+        this->notifier->notifyOrderPlacementFailed(order,
+            "Can't add order with qty less than 1");
+        return false;
+    }
+
+    switch (order.type)
+    {
+        case STOP:
+        case STOPLIMIT:
+        if (order.stopPrice < 1) {
+            this->notifier->notifyOrderPlacementFailed(order,
+                "Can't add stop order with stopPrice less than 1");
+            return false;
+        }
+        default:
+            break;
+    }
+
+    switch (order.type)
+    {
+        case LIMIT:
+        case STOPLIMIT:
+        if (order.price < 1) {
+            this->notifier->notifyOrderPlacementFailed(order,
+                "Can't add limit order with price less than 1");
+            return false;
+        }
+        default:
+            break;
+    }
+
+    if(order.tif == FOK && mode == AUCTION){
+        this->notifier->notifyOrderPlacementFailed(order,
+            "FOK isn't supported in auction mode");
+        return false;
+    }
+
+    // Only orders that take liquidity can fill on arrival; limits never do
+    if((order.tif == IOC || order.tif == FOK) && (order.type == LIMIT || order.type == STOPLIMIT)){
+        this->notifier->notifyOrderPlacementFailed(order,
+            "IOC and FOK only apply to market and stop orders");
+        return false;
+    }
+
+    // Prevent irrational stop limit orders from being added to the book
+    if(order.type == STOPLIMIT)
+    {
+        switch(order.side)
+        {
+            case SELL:
+                if(order.stopPrice < order.price){
+                    this->notifier->notifyOrderPlacementFailed(order, 
+                        "Stop-Limit SELL can't have a stop price below the limit price");
+                    return false;
+                }
+                break;
+            case BUY:
+                if(order.stopPrice > order.price){
+                    this->notifier->notifyOrderPlacementFailed(order, 
+                        "Stop-Limit BUY can't have a stop price above the limit price");
+                    return false;
+                }
+                break;
+        }
+    }
+
+    return true;
+}
+
+template<typename Levels, typename Notifier>
+void BasicMatcher<Levels, Notifier>::matchOrders()
+{
+    releaseTriggeredStops();
+
+    if(marketOrders.empty()){
+        return; // Exit early if there are now market orders
+    }
+
+    OrderRef next = noOrder;
+    for(OrderRef ref = marketOrders.front(); ref != noOrder; ref = next){
+        const HotOrder& order = pool.hot(ref);
+
+        // Skip attempts to match orders if we can
+        bool sideMissing = order.side == BUY ? spread.asksMissing : spread.bidsMissing;
+        bool filled = false;
+
+        if(!sideMissing && (order.tif != FOK || liquidityAvailable(order.side, order.unfilled()))){
+            // Now we try to match this order with limits on the book
+            filled = order.side == BUY ? tryFillBuyMarket(ref) : tryFillSellMarket(ref);
+
+            // Fills move the touch. Stops it crosses join the back of the queue and are matched in this same pass
+            releaseTriggeredStops();
+        }
+        next = pool.node(ref).next;
+
+        if(filled){
+            orderLocations.erase(order.ordId);
+            marketOrders.remove(pool, ref);
+            pool.release(ref);
+        }
+        else if(order.tif == IOC || order.tif == FOK){
+            // Don't leave the rest waiting on the queue
+            cancelRemainder(ref);
+        }
+    }
+};
+
+template<typename Levels, typename Notifier>
+bool BasicMatcher<Levels, Notifier>::liquidityAvailable(Side side, unsigned int qty){
+    // FOK is only accepted on market and stop orders, which take any price, so every level counts
+    unsigned int available = 0;
+    auto addLevel = [&](unsigned short, PriceLevel& level){
+        available += level.openQty;
+        return available < qty;
+    };
+
+    if(side == BUY){
+        sellLimits.ascending(addLevel);
+    }
+    else{
+        buyLimits.descending(addLevel);
+    }
+    return available >= qty;
+}
+
+template<typename Levels, typename Notifier>
+bool BasicMatcher<Levels, Notifier>::tryFillBuyMarket(OrderRef marketOrd){
+    bool marketOrderFilled = false;
+    std::vector<unsigned short> limitPricesToRemove{};
+
+    // Iterate through sell limit price buckets, lowest to highest
+    sellLimits.ascending([&](unsigned short price, PriceLevel& book){
+        marketOrderFilled = matchLimits(marketOrd, book);
+        if(book.orders.empty()){
+            limitPricesToRemove.push_back(price);
+        }
+        return !marketOrderFilled;
+    });
+
+    removeLimitsByPrice(limitPricesToRemove, SELL);
+    refreshBestAsk();
+    return marketOrderFilled;
+}
+
+template<typename Levels, typename Notifier>
+bool BasicMatcher<Levels, Notifier>::tryFillSellMarket(OrderRef marketOrd){
+    bool marketOrderFilled = false;
+    std::vector<unsigned short> limitPricesToRemove{};
+
+    // Iterate through buy limit price buckets, highest to lowest
+    buyLimits.descending([&](unsigned short price, PriceLevel& book){
+        marketOrderFilled = matchLimits(marketOrd, book);
+        if(book.orders.empty()){
+            limitPricesToRemove.push_back(price);
+        }
+        return !marketOrderFilled;
+    });
+
+    removeLimitsByPrice(limitPricesToRemove, BUY);
+    refreshBestBid();
+    return marketOrderFilled;
+}
+
+template<typename Levels, typename Notifier>
+void BasicMatcher<Levels, Notifier>::removeLimitsByPrice(std::vector<unsigned short> limitPricesToRemove, Side side){
+    
+    if(limitPricesToRemove.empty()){
+        return; // early return if there are no limit prices to remove
+    }
+    
+    Levels& levels = side == SELL ? sellLimits : buyLimits;
+    for(auto price : limitPricesToRemove){
+        PriceLevel* level = levels.find(price);
+        if(level && !level->orders.empty()){
+            throw std::logic_error("Can't remove non-empty list of limits!");
+        }
+        levels.erase(price);
+    }
+}
+
+template<typename Levels, typename Notifier>
+bool BasicMatcher<Levels, Notifier>::matchLimits(OrderRef marketOrd, PriceLevel& limitOrds){ 
+    OrderRef next = noOrder;
+    for(OrderRef ref = limitOrds.orders.front(); ref != noOrder; ref = next){
+        next = pool.node(ref).next;
+        HotOrder& limitOrder = pool.hot(ref);
+
+        unsigned int unfilledBefore = limitOrder.unfilled();
+        auto typeFilled = matchMarketAndLimit(marketOrd, ref);
+        limitOrds.openQty -= unfilledBefore - limitOrder.unfilled();
+        
+        if (typeFilled.limit){
+            --limitOrds.numOrders;
+            orderLocations.erase(limitOrder.ordId);
+            limitOrds.orders.remove(pool, ref);
+            pool.release(ref);
+        }
+        
+        if (typeFilled.market){
+            return true;
+        }
+    }
+
+    return false;
+}
+
+template<typename Levels, typename Notifier>
+TypeFilled BasicMatcher<Levels, Notifier>::matchMarketAndLimit(OrderRef marketRef, OrderRef limitRef){
+    HotOrder& marketOrd = pool.hot(marketRef);
+    HotOrder& limitOrd = pool.hot(limitRef);
+    unsigned int limUnFill = limitOrd.unfilled();
+    unsigned int markUnFill = marketOrd.unfilled();
+    unsigned int fillThisMatch = 0;
+    TypeFilled typeFilled = TypeFilled();
+
+    // Limit order can be completely filled
+    if(limUnFill < markUnFill)
+    {
+        fillThisMatch = limUnFill;
+        limitOrd.fill = limitOrd.qty;
+        marketOrd.fill = marketOrd.fill + fillThisMatch;
+        typeFilled.limit = true;
+    }
+    // Market order can be completely filled
+    else if (limUnFill > markUnFill)
+    {
+        fillThisMatch = markUnFill;
+        limitOrd.fill = limitOrd.fill + fillThisMatch;
+        marketOrd.fill = marketOrd.qty;
+        typeFilled.market = true;
+    }
+    // Market and Limit have the same unfilled qty; both can be filled
+    else if (limUnFill == markUnFill){
+        fillThisMatch = markUnFill;
+        limitOrd.fill = limitOrd.qty;
+        marketOrd.fill = marketOrd.qty;
+        typeFilled.both();
+    }
+
+    if(marketOrd.side == BUY){
+        notifyMatch(marketRef, limitRef, fillThisMatch, limitOrd.price, BUY);
+    }
+    else{
+        notifyMatch(limitRef, marketRef, fillThisMatch, limitOrd.price, SELL);
+    }
+    return typeFilled;
+}
+
+template<typename Levels, typename Notifier>
+void BasicMatcher<Levels, Notifier>::notifyMatch(OrderRef buyer, OrderRef seller, unsigned int qty, unsigned short price, Side aggressor){
+    ++version;
+    Match match;
+    match.buyer = MatchParty{pool.hot(buyer).ordId, pool.cold(buyer).traderId};
+    match.seller = MatchParty{pool.hot(seller).ordId, pool.cold(seller).traderId};
+    match.seq = ++lastMatchSeq;
+    match.qty = qty;
+    match.price = price;
+    match.aggressor = aggressor;
+    match.asset = pool.cold(buyer).asset;
+    match.buyerFilled = pool.hot(buyer).unfilled() == 0;
+    match.sellerFilled = pool.hot(seller).unfilled() == 0;
+    this->notifier->notifyOrderMatched(match);
+}
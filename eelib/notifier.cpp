@@ -2,4 +2,3 @@
 #include <iostream>
 #include <string>
 #include <string_view>
-#include <format>
@@ -4,21 +4,23 @@
 #include "match.h"
 #include <vector>
 
-// TODO: add cancelation notifications?
-
 class INotifier{
     public:
     virtual void notifyOrderPlaced(const Order& order) = 0;
     virtual void notifyOrderPlacementFailed(const Order& order, std::string reason) = 0;
     virtual void notifyOrderMatched(const Match& match) = 0;
+    /// @brief The matcher canceled what was left of an order because of its time in force.
+    /// Cancels requested through cancelOrder aren't reported here
+    virtual void notifyOrderCanceled(const Order& order) = 0;
 };
 
-/// @brief Stores events in public vectors
-class InMemoryNotifier: public INotifier{
+/// @brief Stores events in public vectors. Final, so matchers that hold one directly can inline its calls
+class InMemoryNotifier final: public INotifier{
     public:
         std::vector<Order> placedOrders;
         std::vector<Order> placementFailedOrders;
         std::vector<Match> matches;
+        std::vector<Order> canceledOrders;
 
         InMemoryNotifier() = default;
 
@@ -31,4 +33,7 @@ class InMemoryNotifier: public INotifier{
         void notifyOrderMatched(const Match& match){
             matches.push_back(match);
         }
+        void notifyOrderCanceled(const Order& order){
+            canceledOrders.push_back(order);
+        }
 };
\ No newline at end of file
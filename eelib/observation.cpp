@@ -0,0 +1,72 @@
+#include "observation.h"
+#include <algorithm>
+
+void Observation::setBook(Symbol asset, const Spread& spread, const Depth& depth){
+    if(asset.id() >= books.size()){
+        books.resize(asset.id() + 1);
+    }
+    BookSlot& book = books[asset.id()];
+    book.hasBook = true;
+    book.spread = spread;
+
+    // Move to the end of the arena if the depth no longer fits where it is
+    size_t needed = depth.bidBins.size() + depth.askBins.size();
+    if(needed > book.capacity){
+        wasted += book.capacity;
+        book.start = bins.size();
+        book.capacity = (unsigned int)needed;
+        bins.resize(bins.size() + needed);
+    }
+
+    std::copy(depth.bidBins.begin(), depth.bidBins.end(), bins.begin() + book.start);
+    std::copy(depth.askBins.begin(), depth.askBins.end(), bins.begin() + book.start + depth.bidBins.size());
+    book.numBids = (unsigned int)depth.bidBins.size();
+    book.numAsks = (unsigned int)depth.askBins.size();
+
+    if(wasted > bins.size() / 2){
+        compact();
+    }
+}
+
+void Observation::compact(){
+    spareBins.clear();
+    for(auto& book : books){
+        size_t used = book.numBids + book.numAsks;
+        spareBins.insert(spareBins.end(), bins.begin() + book.start, bins.begin() + book.start + used);
+        book.start = spareBins.size() - used;
+        book.capacity = (unsigned int)used;
+    }
+    bins.swap(spareBins);
+    wasted = 0;
+}
+
+bool Observation::hasBook(Symbol asset) const{
+    const BookSlot* book = slot(asset);
+    return book && book->hasBook;
+}
+
+Spread Observation::spread(Symbol asset) const{
+    const BookSlot* book = slot(asset);
+    return book ? book->spread : Spread();
+}
+
+PriceBinSpan Observation::bids(Symbol asset) const{
+    const BookSlot* book = slot(asset);
+    if(!book || book->numBids == 0) return PriceBinSpan();
+    return PriceBinSpan{bins.data() + book->start, book->numBids};
+}
+
+PriceBinSpan Observation::asks(Symbol asset) const{
+    const BookSlot* book = slot(asset);
+    if(!book || book->numAsks == 0) return PriceBinSpan();
+    return PriceBinSpan{bins.data() + book->start + book->numBids, book->numAsks};
+}
+
+Depth Observation::depth(Symbol asset) const{
+    Depth depth;
+    PriceBinSpan bidSpan = bids(asset);
+    PriceBinSpan askSpan = asks(asset);
+    depth.bidBins.assign(bidSpan.begin(), bidSpan.end());
+    depth.askBins.assign(askSpan.begin(), askSpan.end());
+    return depth;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "matcher.h"
+#include "symbol.h"
+#include "tick.h"
+#include <cstddef>
+#include <vector>
+
+/// @brief Read only run of price bins inside an Observation. Valid until the observation is next updated
+struct PriceBinSpan{
+    const PriceBin* first = nullptr;
+    size_t count = 0;
+
+    const PriceBin* begin() const { return first; }
+    const PriceBin* end() const { return first + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const PriceBin& operator[](size_t i) const { return first[i]; }
+};
+
+/*
+What agents see of the market.
+
+Books are kept in a flat array indexed by Symbol::id(), and the depth bins of every book share one arena.
+Reading an asset is an index rather than a lookup on its name, and updating a book reuses its space
+in the arena unless its depth grew. Every accessor also takes a name, so observation.spread("FOOD") still works
+for code that only has the name, at the cost of a symbol table lookup. Those lookups don't intern names,
+so asking about an asset that was never traded leaves the symbol table alone and sees no book.
+*/
+class Observation{
+
+    /// @brief One asset's book. Its bids, then its asks, sit in bins from start on
+    struct BookSlot{
+        bool hasBook = false;
+        Spread spread;
+        size_t start = 0;
+        unsigned int numBids = 0;
+        unsigned int numAsks = 0;
+        /// @brief Bins reserved for this asset in the arena
+        unsigned int capacity = 0;
+    };
+
+    /// @brief Asset id - book
+    std::vector<BookSlot> books;
+
+    /// @brief Depth bins of every book
+    std::vector<PriceBin> bins;
+    /// @brief Arena bins no book uses any more. Compacted once they are half the arena
+    size_t wasted = 0;
+    /// @brief Spare arena for compaction, so the two swap rather than reallocate
+    std::vector<PriceBin> spareBins;
+
+    const BookSlot* slot(Symbol asset) const {
+        return asset.id() < books.size() ? &books[asset.id()] : nullptr;
+    }
+
+    void compact();
+
+    public:
+        tick time;
+
+        /// @brief Replace what is known about an asset's book
+        void setBook(Symbol asset, const Spread& spread, const Depth& depth = Depth());
+
+        /// @brief False for assets nobody has traded yet
+        bool hasBook(Symbol asset) const;
+
+        /// @brief Best bid and ask. Both sides are missing if the asset has no book
+        Spread spread(Symbol asset) const;
+
+        /// @brief Cumulative bids, highest price first
+        PriceBinSpan bids(Symbol asset) const;
+        /// @brief Cumulative asks, lowest price first
+        PriceBinSpan asks(Symbol asset) const;
+
+        /// @brief Owning copy of an asset's depth
+        Depth depth(Symbol asset) const;
+
+        bool hasBook(const std::string& name) const { return hasBook(Symbol::find(name)); }
+        bool hasBook(const char* name) const { return hasBook(Symbol::find(name)); }
+        Spread spread(const std::string& name) const { return spread(Symbol::find(name)); }
+        Spread spread(const char* name) const { return spread(Symbol::find(name)); }
+        PriceBinSpan bids(const std::string& name) const { return bids(Symbol::find(name)); }
+        PriceBinSpan bids(const char* name) const { return bids(Symbol::find(name)); }
+        PriceBinSpan asks(const std::string& name) const { return asks(Symbol::find(name)); }
+        PriceBinSpan asks(const char* name) const { return asks(Symbol::find(name)); }
+        Depth depth(const std::string& name) const { return depth(Symbol::find(name)); }
+        Depth depth(const char* name) const { return depth(Symbol::find(name)); }
+
+        /// @brief Asset ids below this may have a book
+        size_t numAssets() const { return books.size(); }
+};
@@ -1,12 +1,24 @@
-
 #include <string>
 #include "order.h"
 
-const unsigned int Order::amt(){
-    return qty * price;
+namespace {
+
+/*
+https://www.onixs.biz/fix-dictionary/4.4/glossary.html#Stop:~:text=Stop-,A%20stop%20order%20to%20buy%20which%20becomes%20a%20market%20order%20when,stop%20price%20after%20the%20order%20is%20represented%20in%20the%20Trading%20Crowd.,-OrdType%20%3C40%3E      
+Treat buy-stop as a buy-market if marketPrice >= price
+Treat sell-stop as a sell-market if marketPrice <= price
+*/
+bool stopReached(Side side, unsigned short stopPrice, const Spread& spread){
+    if (side == BUY) {
+        if (spread.asksMissing) return false;
+        return spread.lowestAsk >= stopPrice;
+    } else {
+        if (spread.bidsMissing) return false;
+        return spread.highestBid <= stopPrice;
+    }
 }
 
-const bool Order::treatAsMarket(const Spread& spread){
+bool treatAsMarket(OrdType type, Side side, unsigned short stopPrice, const Spread& spread){
     switch(type){
         case MARKET:
             return true;
@@ -14,40 +26,36 @@ const bool Order::treatAsMarket(const Spread& spread){
             return false;
         case STOPLIMIT:
             return false;
-        case STOP : {
-
-            /*
-            https://www.onixs.biz/fix-dictionary/4.4/glossary.html#Stop:~:text=Stop-,A%20stop%20order%20to%20buy%20which%20becomes%20a%20market%20order%20when,stop%20price%20after%20the%20order%20is%20represented%20in%20the%20Trading%20Crowd.,-OrdType%20%3C40%3E      
-            Treat buy-stop as a buy-market if marketPrice >= price
-            Treat sell-stop as a sell-market if marketPrice <= price
-            */
-            if (side == BUY) {
-                if (spread.asksMissing) return false;
-                return spread.lowestAsk >= stopPrice;
-            } else {
-                if (spread.bidsMissing) return false;
-                return spread.highestBid <= stopPrice;
-            }
-        }
+        case STOP:
+            return stopReached(side, stopPrice, spread);
     }
+    return false;
 }
 
-const bool Order::treatAsLimit(const Spread& spread){
+bool treatAsLimit(OrdType type, Side side, unsigned short stopPrice, const Spread& spread){
     switch(type){
         case MARKET:
             return false;
         case LIMIT:
             return true;
         case STOPLIMIT:
-            if(side == BUY){
-                if (spread.asksMissing) return false;
-                return spread.lowestAsk >= stopPrice;
-            } else {
-                if (spread.bidsMissing) return false;
-                return spread.highestBid <= stopPrice;
-            }
-        case STOP : {
+            return stopReached(side, stopPrice, spread);
+        case STOP:
             return false;
-        }
     }
-}
\ No newline at end of file
+    return false;
+}
+
+}
+
+const unsigned int Order::amt(){
+    return qty * price;
+}
+
+const bool Order::treatAsMarket(const Spread& spread) const{
+    return ::treatAsMarket(type, side, stopPrice, spread);
+}
+
+const bool Order::treatAsLimit(const Spread& spread) const{
+    return ::treatAsLimit(type, side, stopPrice, spread);
+}
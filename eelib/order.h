@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include "symbol.h"
 
 struct Spread{
     bool bidsMissing = true;
@@ -8,10 +9,15 @@ struct Spread{
 
     unsigned short highestBid = 0;
     unsigned short lowestAsk = 0;
+
+    /// @brief Unfilled qty resting at the highest bid
+    unsigned int highestBidQty = 0;
+    /// @brief Unfilled qty resting at the lowest ask
+    unsigned int lowestAskQty = 0;
 };
 
 /// @brief Subset of the order types found here: https://www.onixs.biz/fix-dictionary/4.4/tagNum_40.html
-enum OrdType{
+enum OrdType : unsigned char {
 
     /// @brief matched with the best limit on the book
     MARKET = 1,
@@ -26,36 +32,53 @@ enum OrdType{
     STOPLIMIT = 4
 };
 
-enum Side {
+enum Side : unsigned char {
     BUY = 1,
     SELL = 2,
 };
 
+/// @brief Subset of the time in force values found here: https://www.onixs.biz/fix-dictionary/4.4/tagNum_59.html
+enum TimeInForce : unsigned char {
+
+    /// @brief canceled by the matcher at the end of the trading day
+    DAY = 0,
+
+    /// @brief rests on the book until filled or canceled
+    GTC = 1,
+
+    /// @brief fills what it can as soon as it is active, the rest is canceled
+    IOC = 3,
+
+    /// @brief fills completely as soon as it is active, or is canceled without filling
+    FOK = 4
+};
+
+/// @brief An order as agents and notifiers see it. Fields are ordered to pack into 48 bytes
 struct Order{
 
     /// @brief Id of the trader that placed this order
-    long traderId;
+    long traderId = 0;
     /// @brief Unique id of this order
-    long ordId;
-    /// @brief Buy or Sell
-    Side side;
+    long ordId = 0;
+    /// @brief Time the order was recieved by the service
+    unsigned long ordNum = 0;
     /// @brief Quantity of the order.
     unsigned int qty;
+    /// @brief Number of items filled. 
+    unsigned int fill = 0;
     /// @brief Price of the order in cents.
     unsigned short price;
     /// @brief Stop price of the order.
     unsigned short stopPrice;
     /// @brief Asset
-    std::string asset;
+    Symbol asset;
+    /// @brief Buy or Sell
+    Side side;
     /// @brief Order type (Market, Limit, Stop).
     OrdType type;
+    /// @brief How long the order stays on the book
+    TimeInForce tif = GTC;
 
-    // TODO add group number for bulk matching
-
-    /// @brief Time the order was recieved by the service
-    unsigned long ordNum;
-    /// @brief Number of items filled. 
-    unsigned int fill = 0;
     /// @brief Calculate the total amount of the order.
     /// @return The total amount in cents.
     const unsigned int amt();
@@ -63,18 +86,18 @@ struct Order{
     /// @brief Determine if the order should be treated as a market order based on the current market price.
     /// @param marketPrice 
     /// @return 
-    const bool treatAsMarket(const Spread& spread);
+    const bool treatAsMarket(const Spread& spread) const;
 
     /// @brief Determine if the order should be treated as a limit order based on the current market price
     /// @param spread 
     /// @return 
-    const bool treatAsLimit(const Spread& spread);
+    const bool treatAsLimit(const Spread& spread) const;
 
-    const bool fillComplete(){
+    const bool fillComplete() const{
         return qty == fill;
     }
 
-    const unsigned int unfilled(){
+    const unsigned int unfilled() const{
         // A bit dangerous. unfilled should NEVER be negative
         return qty - fill;
     }
@@ -82,12 +105,13 @@ struct Order{
     Order() = default;
 
     Order(
-        std::string asset_,
+        Symbol asset_,
         Side side_,
         OrdType type_,
         unsigned short price_ = 0,
         unsigned int qty_ = 0,
-        unsigned short stopPrice_ = 0
+        unsigned short stopPrice_ = 0,
+        TimeInForce tif_ = GTC
     ){
         asset = asset_;
         side = side_;
@@ -95,5 +119,35 @@ struct Order{
         price = price_;
         qty = qty_;
         stopPrice = stopPrice_;
+        tif = tif_;
     }
-};
\ No newline at end of file
+};
+
+static_assert(sizeof(Order) <= 48, "Order should stay compact");
+
+/// @brief The part of an order the matching loop reads and writes. Everything else stays out of the way in ColdOrder
+struct HotOrder{
+    long ordId;
+    unsigned long ordNum;
+    unsigned int qty;
+    unsigned int fill;
+    unsigned short price;
+    unsigned short stopPrice;
+    Side side;
+    OrdType type;
+    TimeInForce tif;
+    /// @brief Set once a stop or stop limit leaves the stop index for the active book
+    bool triggered = false;
+
+    const unsigned int unfilled() const{
+        return qty - fill;
+    }
+};
+
+static_assert(sizeof(HotOrder) <= 32, "HotOrder should fit in half a cache line");
+
+/// @brief Order fields matching never looks at
+struct ColdOrder{
+    long traderId;
+    Symbol asset;
+};
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "order.h"
+#include <vector>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+/// @brief Handle to a node in an OrderPool
+using OrderRef = std::uint32_t;
+constexpr OrderRef noOrder = std::numeric_limits<OrderRef>::max();
+
+/// @brief Order linked into an OrderQueue
+struct OrderNode{
+    HotOrder order;
+    OrderRef prev = noOrder;
+    OrderRef next = noOrder;
+};
+
+/// @brief Hands out order nodes by index from fixed size slabs. Released nodes go on a free list and are
+/// reused before a new slab is allocated, so a book in steady state doesn't allocate, and growing never moves
+/// the nodes already handed out. Hot fields live in nodes, cold fields in parallel slabs at the same index,
+/// so walking a queue only touches the hot data.
+class OrderPool{
+    static constexpr unsigned slabShift = 10;
+    static constexpr OrderRef slabSize = OrderRef(1) << slabShift;
+    static constexpr OrderRef slabMask = slabSize - 1;
+
+    std::vector<std::unique_ptr<OrderNode[]>> nodeSlabs;
+    std::vector<std::unique_ptr<ColdOrder[]>> coldSlabs;
+    /// @brief Nodes handed out so far, counting released ones. The next new node gets this index
+    OrderRef numNodes = 0;
+    OrderRef freeList = noOrder;
+
+    const OrderNode& nodeAt(OrderRef ref) const { return nodeSlabs[ref >> slabShift][ref & slabMask]; }
+    const ColdOrder& coldAt(OrderRef ref) const { return coldSlabs[ref >> slabShift][ref & slabMask]; }
+
+    public:
+        OrderRef acquire(const Order& order){
+            OrderRef ref;
+            if(freeList != noOrder){
+                ref = freeList;
+                freeList = node(ref).next;
+            }
+            else{
+                if((numNodes & slabMask) == 0){
+                    nodeSlabs.emplace_back(new OrderNode[slabSize]);
+                    coldSlabs.emplace_back(new ColdOrder[slabSize]);
+                }
+                ref = numNodes++;
+            }
+
+            OrderNode& fresh = node(ref);
+            fresh.order = HotOrder{order.ordId, order.ordNum, order.qty, order.fill,
+                order.price, order.stopPrice, order.side, order.type, order.tif};
+            fresh.prev = noOrder;
+            fresh.next = noOrder;
+            coldSlabs[ref >> slabShift][ref & slabMask] = ColdOrder{order.traderId, order.asset};
+            return ref;
+        }
+
+        void release(OrderRef ref){
+            OrderNode& released = node(ref);
+            released.prev = noOrder;
+            released.next = freeList;
+            freeList = ref;
+        }
+
+        OrderNode& node(OrderRef ref) { return nodeSlabs[ref >> slabShift][ref & slabMask]; }
+        HotOrder& hot(OrderRef ref) { return node(ref).order; }
+        const ColdOrder& cold(OrderRef ref) const { return coldAt(ref); }
+
+        /// @brief Put the hot and cold halves back together
+        Order toOrder(OrderRef ref) const {
+            const HotOrder& hot = nodeAt(ref).order;
+            const ColdOrder& cold = coldAt(ref);
+            Order order;
+            order.traderId = cold.traderId;
+            order.ordId = hot.ordId;
+            order.ordNum = hot.ordNum;
+            order.qty = hot.qty;
+            order.fill = hot.fill;
+            order.price = hot.price;
+            order.stopPrice = hot.stopPrice;
+            order.asset = cold.asset;
+            order.side = hot.side;
+            order.type = hot.type;
+            order.tif = hot.tif;
+            return order;
+        }
+};
+
+/// @brief Intrusive doubly linked FIFO queue of pooled order nodes. The queue doesn't own its nodes;
+/// they must be released back to their pool after being removed.
+class OrderQueue{
+    OrderRef head = noOrder;
+    OrderRef tail = noOrder;
+
+    public:
+        bool empty() const { return head == noOrder; }
+        OrderRef front() const { return head; }
+
+        void pushBack(OrderPool& pool, OrderRef ref){
+            OrderNode& node = pool.node(ref);
+            node.prev = tail;
+            node.next = noOrder;
+            if(tail != noOrder){
+                pool.node(tail).next = ref;
+            }
+            else{
+                head = ref;
+            }
+            tail = ref;
+        }
+
+        /// @brief Unlink a node from anywhere in the queue
+        void remove(OrderPool& pool, OrderRef ref){
+            OrderNode& node = pool.node(ref);
+            if(node.prev != noOrder){
+                pool.node(node.prev).next = node.next;
+            }
+            else{
+                head = node.next;
+            }
+            if(node.next != noOrder){
+                pool.node(node.next).prev = node.prev;
+            }
+            else{
+                tail = node.prev;
+            }
+            node.prev = noOrder;
+            node.next = noOrder;
+        }
+
+        /// @brief Forget all nodes without touching them
+        void clear(){
+            head = noOrder;
+            tail = noOrder;
+        }
+};
@@ -0,0 +1,73 @@
+#include "population.h"
+
+// ConsumerPopulation Implementation
+
+size_t ConsumerPopulation::addMember(Symbol asset, unsigned short maxPrice, tick appetiteCoef){
+    assets.push_back(asset);
+    maxPrices.push_back(maxPrice);
+    ticksUntilHalfHunger.push_back((double)appetiteCoef.raw());
+    lastConsumed.push_back(0);
+    lastPlacedOrderIds.push_back(0);
+    prices.push_back(0);
+    return assets.size() - 1;
+}
+
+void ConsumerPopulation::policies(const Observation& observation, size_t begin, size_t end, PopulationActions& actions){
+    const tick::rep now = observation.time.raw();
+
+    // Hunger pricing for the whole range. Plain arithmetic over columns, so the compiler can vectorize it
+    for(size_t i = begin; i < end; ++i){
+        // Don't start hungry
+        tick::rep consumed = lastConsumed[i] == 0 ? now : lastConsumed[i];
+        lastConsumed[i] = consumed;
+
+        double sinceConsumed = consumed > 0 && now > consumed ? (double)(now - consumed) : 0.0;
+        prices[i] = (unsigned short)(fast_sigmoid(sinceConsumed / ticksUntilHalfHunger[i]) * maxPrices[i]);
+    }
+
+    for(size_t i = begin; i < end; ++i){
+        if(lastPlacedOrderIds[i] > 0){
+            actions.cancels.push_back(MemberOrderId{i, lastPlacedOrderIds[i]});
+        }
+        // qty always set to 1 to avoid partial fills
+        actions.orders.push_back(MemberOrder{i, Order(assets[i], BUY, LIMIT, prices[i], 1)});
+    }
+}
+
+void ConsumerPopulation::ordersPlaced(const std::vector<MemberOrderId>& placed, tick now){
+    for(auto& entry : placed){
+        lastPlacedOrderIds[entry.member] = entry.ordId;
+    }
+}
+
+void ConsumerPopulation::matchesFound(const std::vector<MemberFill>& fills, tick now){
+    for(auto& fill : fills){
+        lastConsumed[fill.member] = now.raw();
+    }
+}
+
+// ProducerPopulation Implementation
+
+size_t ProducerPopulation::addMember(Symbol asset, unsigned short preferedPrice){
+    assets.push_back(asset);
+    preferedPrices.push_back(preferedPrice);
+    qtyPerTick.push_back(1);
+    return assets.size() - 1;
+}
+
+void ProducerPopulation::policies(const Observation& observation, size_t begin, size_t end, PopulationActions& actions){
+    for(size_t i = begin; i < end; ++i){
+        Spread assetSpread = observation.spread(assets[i]);
+
+        // Reduce production if bids are missing
+        if(assetSpread.bidsMissing || assetSpread.highestBid < preferedPrices[i]){
+            if(qtyPerTick[i] > 0) --qtyPerTick[i];
+        }
+        else if(assetSpread.highestBid > preferedPrices[i]){
+            ++qtyPerTick[i];
+        }
+
+        // Whatever isn't sold this step is dropped rather than left on the book
+        actions.orders.push_back(MemberOrder{i, Order(assets[i], SELL, MARKET, 0, qtyPerTick[i], 0, DAY)});
+    }
+}
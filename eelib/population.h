@@ -0,0 +1,103 @@
+#pragma once
+
+#include "agent.h"
+#include "match.h"
+#include "observation.h"
+#include "symbol.h"
+#include "tick.h"
+#include <cstddef>
+#include <vector>
+
+/// @brief An order a population member wants placed
+struct MemberOrder{
+    size_t member;
+    Order order;
+};
+
+/// @brief An order id tied to the population member that owns it
+struct MemberOrderId{
+    size_t member;
+    long ordId;
+};
+
+/// @brief A fill a population member took part in
+struct MemberFill{
+    size_t member;
+    Match match;
+};
+
+/// @brief What a range of members decided this step. Entries are in member order
+struct PopulationActions{
+    std::vector<MemberOrderId> cancels;
+    std::vector<MemberOrder> orders;
+
+    void clear(){
+        cancels.clear();
+        orders.clear();
+    }
+};
+
+/*
+Many agents of one kind, stored column by column.
+
+A population keeps each field of its members in its own array and decides for a whole range of members
+in one call, so simple agents cost a few array slots instead of a heap object and a virtual call each.
+The ABM gives every member a trader id from one consecutive block, and reports placements, cancels and
+fills back to the population in batches.
+
+Members can't be added once the population is in an ABM, or removed.
+*/
+class Population{
+    public:
+        virtual ~Population() = default;
+
+        virtual size_t size() const = 0;
+
+        /// @brief Decide for members [begin, end). Ranges may be evaluated on different threads at the same time,
+        /// so only touch state of members in the range. Write cancels and orders in member order
+        virtual void policies(const Observation& observation, size_t begin, size_t end, PopulationActions& actions) = 0;
+
+        /// @brief Orders accepted by a book this step, in placement order
+        virtual void ordersPlaced(const std::vector<MemberOrderId>& placed, tick now){};
+
+        /// @brief Orders canceled this step, whether asked for or expired
+        virtual void ordersCanceled(const std::vector<MemberOrderId>& canceled, tick now){};
+
+        /// @brief Every fill members took part in this step, in match order
+        virtual void matchesFound(const std::vector<MemberFill>& fills, tick now){};
+};
+
+/// @brief Consumers, column by column. Members behave exactly like Consumer agents
+class ConsumerPopulation : public Population{
+    std::vector<Symbol> assets;
+    std::vector<unsigned short> maxPrices;
+    std::vector<double> ticksUntilHalfHunger;
+    std::vector<tick::rep> lastConsumed;
+    std::vector<long> lastPlacedOrderIds;
+
+    /// @brief Scratch. This step's limit price for each member
+    std::vector<unsigned short> prices;
+
+    public:
+        /// @return member index
+        size_t addMember(Symbol asset, unsigned short maxPrice, tick appetiteCoef);
+
+        size_t size() const override { return assets.size(); }
+        void policies(const Observation& observation, size_t begin, size_t end, PopulationActions& actions) override;
+        void ordersPlaced(const std::vector<MemberOrderId>& placed, tick now) override;
+        void matchesFound(const std::vector<MemberFill>& fills, tick now) override;
+};
+
+/// @brief Producers, column by column. Members behave exactly like Producer agents
+class ProducerPopulation : public Population{
+    std::vector<Symbol> assets;
+    std::vector<unsigned short> preferedPrices;
+    std::vector<unsigned int> qtyPerTick;
+
+    public:
+        /// @return member index
+        size_t addMember(Symbol asset, unsigned short preferedPrice);
+
+        size_t size() const override { return assets.size(); }
+        void policies(const Observation& observation, size_t begin, size_t end, PopulationActions& actions) override;
+};
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "order.h"
+#include "orderpool.h"
+#include <vector>
+#include <map>
+#include <cstddef>
+#include <cstdint>
+
+/// @brief FIFO queue of orders resting at a single price
+struct PriceLevel{
+    OrderQueue orders;
+
+    /// @brief Number of orders at this price. Updated on insert, fill and cancel
+    unsigned int numOrders = 0;
+    /// @brief Unfilled qty of orders at this price. Updated on insert, fill and cancel
+    unsigned int openQty = 0;
+
+    void clear(){
+        orders.clear();
+        numOrders = 0;
+        openQty = 0;
+    }
+};
+
+/*
+Price level containers for one side of a book. Both expose the same interface so
+BasicMatcher can be instantiated with either:
+
+    PriceLevel* find(price)            level at price, or nullptr
+    PriceLevel& getOrCreate(price)     level at price, created if missing
+    void erase(price)                  drop the level at price
+    bool empty()
+    void ascending(visit)              visit(price, level) lowest -> highest, stop when visit returns false
+    void descending(visit)             visit(price, level) highest -> lowest, stop when visit returns false
+
+Levels must not be created or erased from inside a visit.
+*/
+
+/// @brief Price levels kept in a balanced tree. Memory grows with the number of occupied prices
+class MapPriceLevels{
+    std::map<unsigned short, PriceLevel> levels;
+
+    public:
+        PriceLevel* find(unsigned short price){
+            auto it = levels.find(price);
+            return it == levels.end() ? nullptr : &it->second;
+        }
+
+        PriceLevel& getOrCreate(unsigned short price){
+            return levels[price];
+        }
+
+        void erase(unsigned short price){
+            levels.erase(price);
+        }
+
+        bool empty() const { return levels.empty(); }
+
+        template<typename Visit>
+        void ascending(Visit&& visit){
+            for(auto& [price, level] : levels){
+                if(!visit(price, level)) break;
+            }
+        }
+
+        template<typename Visit>
+        void descending(Visit&& visit){
+            for(auto it = levels.rbegin(); it != levels.rend(); ++it){
+                if(!visit(it->first, it->second)) break;
+            }
+        }
+};
+
+/// @brief Price levels in a flat array indexed by price, covering the whole unsigned short domain.
+/// An occupancy bitmap lets sweeps jump over empty prices a word at a time.
+/// Levels are allocated on first use.
+class LadderPriceLevels{
+    static constexpr size_t numPrices = 1 << 16;
+    static constexpr size_t wordBits = 64;
+    static constexpr size_t numWords = numPrices / wordBits;
+
+    std::vector<PriceLevel> levels;
+    std::vector<std::uint64_t> occupied = std::vector<std::uint64_t>(numWords, 0);
+    size_t numOccupied = 0;
+
+    bool isOccupied(size_t price) const {
+        return occupied[price / wordBits] & (std::uint64_t{1} << (price % wordBits));
+    }
+
+    /// @brief Lowest occupied price >= from, or -1
+    long nextOccupied(long from) const {
+        if(from >= (long)numPrices) return -1;
+        size_t word = from / wordBits;
+        std::uint64_t bits = occupied[word] & (~std::uint64_t{0} << (from % wordBits));
+        while(true){
+            if(bits) return word * wordBits + __builtin_ctzll(bits);
+            if(++word == numWords) return -1;
+            bits = occupied[word];
+        }
+    }
+
+    /// @brief Highest occupied price <= from, or -1
+    long prevOccupied(long from) const {
+        if(from < 0) return -1;
+        size_t word = from / wordBits;
+        size_t shift = wordBits - 1 - (from % wordBits);
+        std::uint64_t bits = occupied[word] & (~std::uint64_t{0} >> shift);
+        while(true){
+            if(bits) return word * wordBits + (wordBits - 1 - __builtin_clzll(bits));
+            if(word-- == 0) return -1;
+            bits = occupied[word];
+        }
+    }
+
+    public:
+        PriceLevel* find(unsigned short price){
+            return isOccupied(price) ? &levels[price] : nullptr;
+        }
+
+        PriceLevel& getOrCreate(unsigned short price){
+            if(levels.empty()){
+                levels.resize(numPrices);
+            }
+            if(!isOccupied(price)){
+                occupied[price / wordBits] |= std::uint64_t{1} << (price % wordBits);
+                ++numOccupied;
+            }
+            return levels[price];
+        }
+
+        void erase(unsigned short price){
+            if(!isOccupied(price)) return;
+            occupied[price / wordBits] &= ~(std::uint64_t{1} << (price % wordBits));
+            --numOccupied;
+            levels[price].clear();
+        }
+
+        bool empty() const { return numOccupied == 0; }
+
+        template<typename Visit>
+        void ascending(Visit&& visit){
+            for(long p = nextOccupied(0); p >= 0; p = nextOccupied(p + 1)){
+                if(!visit((unsigned short)p, levels[p])) break;
+            }
+        }
+
+        template<typename Visit>
+        void descending(Visit&& visit){
+            for(long p = prevOccupied(numPrices - 1); p >= 0; p = prevOccupied(p - 1)){
+                if(!visit((unsigned short)p, levels[p])) break;
+            }
+        }
+};
@@ -0,0 +1,100 @@
+#include "symbol.h"
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+/*
+Interned asset names.
+
+Names sit in fixed size chunks that are never moved or freed, so name() can index them without a lock:
+a chunk pointer is published with a release store before any id in it is handed out. Only the name - id
+map needs the lock, and lookups of names already interned share it.
+*/
+struct SymbolTable{
+    static constexpr unsigned chunkShift = 12;
+    static constexpr Symbol::rep chunkSize = Symbol::rep(1) << chunkShift;
+    static constexpr Symbol::rep chunkMask = chunkSize - 1;
+    static constexpr size_t maxChunks = 4096;
+
+    std::shared_mutex mutex;
+    std::unordered_map<std::string, Symbol::rep> ids{{"", 0}};
+
+    std::atomic<std::string*> chunks[maxChunks]{};
+    std::atomic<Symbol::rep> size{1};
+
+    SymbolTable(){
+        chunks[0].store(new std::string[chunkSize], std::memory_order_release);
+    }
+
+    ~SymbolTable(){
+        for(auto& chunk : chunks){
+            delete[] chunk.load(std::memory_order_relaxed);
+        }
+    }
+
+    const std::string& at(Symbol::rep id) const{
+        return chunks[id >> chunkShift].load(std::memory_order_acquire)[id & chunkMask];
+    }
+
+    /// @brief Only with the mutex held exclusively
+    Symbol::rep append(const std::string& name){
+        Symbol::rep id = size.load(std::memory_order_relaxed);
+        size_t chunk = id >> chunkShift;
+        if(chunk >= maxChunks){
+            throw std::length_error("Too many symbols");
+        }
+        if((id & chunkMask) == 0){
+            chunks[chunk].store(new std::string[chunkSize], std::memory_order_release);
+        }
+        chunks[chunk].load(std::memory_order_relaxed)[id & chunkMask] = name;
+        size.store(id + 1, std::memory_order_release);
+        return id;
+    }
+};
+
+SymbolTable& table(){
+    static SymbolTable instance;
+    return instance;
+}
+
+}
+
+Symbol::Symbol(const std::string& name){
+    if(name.empty()){
+        return;
+    }
+    auto& t = table();
+    {
+        std::shared_lock<std::shared_mutex> lock(t.mutex);
+        auto found = t.ids.find(name);
+        if(found != t.ids.end()){
+            id_ = found->second;
+            return;
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(t.mutex);
+    auto found = t.ids.find(name);
+    if(found == t.ids.end()){
+        found = t.ids.emplace(name, t.append(name)).first;
+    }
+    id_ = found->second;
+}
+
+Symbol Symbol::find(const std::string& name){
+    auto& t = table();
+    std::shared_lock<std::shared_mutex> lock(t.mutex);
+    auto found = t.ids.find(name);
+    return found != t.ids.end() ? Symbol(found->second, 0) : Symbol();
+}
+
+const std::string& Symbol::name() const{
+    return table().at(id_);
+}
+
+Symbol::rep Symbol::count(){
+    return table().size.load(std::memory_order_acquire);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <ostream>
+#include <functional>
+
+/// @brief Small integer id standing in for an asset name.
+/// Names are interned once into a process wide table when a Symbol is made from a string,
+/// after that copying, comparing and hashing a Symbol never touches the string.
+/// Interned names are never dropped. Reading a name back doesn't lock, so any thread can call name()
+class Symbol{
+    public:
+        using rep = std::uint32_t;
+
+    private:
+        /// @brief 0 is the empty name
+        rep id_ = 0;
+
+        explicit Symbol(rep id, int) : id_(id) {}
+
+    public:
+        Symbol() = default;
+        Symbol(const std::string& name);
+        Symbol(const char* name) : Symbol(std::string(name)) {}
+
+        /// @brief Symbol for an id handed out earlier by id()
+        static Symbol fromId(rep id) { return Symbol(id, 0); }
+
+        /// @brief Symbol of a name interned earlier, or the empty Symbol if it never was. Doesn't intern the name,
+        /// so read only lookups by name don't grow the table
+        static Symbol find(const std::string& name);
+
+        rep id() const { return id_; }
+        const std::string& name() const;
+
+        /// @brief Number of names interned so far, including the empty name. Ids are below this
+        static rep count();
+
+        friend bool operator==(Symbol a, Symbol b) { return a.id_ == b.id_; }
+        friend bool operator!=(Symbol a, Symbol b) { return a.id_ != b.id_; }
+        friend bool operator<(Symbol a, Symbol b) { return a.id_ < b.id_; }
+
+        friend bool operator==(Symbol a, const std::string& b) { return a.name() == b; }
+        friend bool operator==(const std::string& a, Symbol b) { return a == b.name(); }
+        friend bool operator==(Symbol a, const char* b) { return a.name() == b; }
+        friend bool operator==(const char* a, Symbol b) { return a == b.name(); }
+
+        friend std::ostream& operator<<(std::ostream& os, Symbol s) {
+            return os << s.name();
+        }
+};
+
+namespace std{
+    template<>
+    struct hash<Symbol>{
+        size_t operator()(Symbol s) const noexcept { return s.id(); }
+    };
+}
@@ -1,6 +1,10 @@
 #include <gtest/gtest.h>
 #include "../abm.h"
 #include "../agent.h"
+#include <functional>
+#include <map>
+#include <random>
+#include <string>
 
 class MockAgent : public Agent {
 public:
@@ -121,8 +125,8 @@ TEST_F(ABMTest, ProducerConsumerOneStep) {
     EXPECT_EQ(obs.time, tick(1));
 
     // Make sure the FOOD order book is in an expected state
-    ASSERT_TRUE(obs.assetOrderDepths.count("FOOD"));
-    Depth depth = obs.assetOrderDepths.at("FOOD");
+    ASSERT_TRUE(obs.hasBook("FOOD"));
+    Depth depth = obs.depth("FOOD");
 
     // Producer (Market Sell 1) should match with one Consumer (Limit Buy 1).
     // 3 Consumers total -> 3 Bids.
@@ -134,6 +138,9 @@ TEST_F(ABMTest, ProducerConsumerOneStep) {
     EXPECT_EQ(depth.bidBins[0].totalQty, 2); // 2 remaining
 
     EXPECT_TRUE(depth.askBins.empty());
+
+    // Filled orders leave the routing table
+    EXPECT_EQ(abm.getNumOpenOrders(), 2);
 }
 
 TEST_F(ABMTest, MultipleStepsIncrementTickCounter) {
@@ -226,19 +233,21 @@ TEST_F(ABMTest, CancellationRouting) {
 
     // Verify order is on the book
     auto obs = abm.getLatestObservation();
-    Depth depth = obs.assetOrderDepths.at("FOOD");
+    Depth depth = obs.depth("FOOD");
     ASSERT_EQ(depth.askBins.size(), 1);
     EXPECT_EQ(depth.askBins[0].totalQty, 1);
+    EXPECT_EQ(abm.getNumOpenOrders(), 1);
 
     // Tick 1 -> 2: Cancel Order
     abm.simStep();
+    EXPECT_EQ(abm.getNumOpenOrders(), 0);
 
     // Verify cancellation callback
     EXPECT_TRUE(pAgent->cancellationConfirmed);
 
     // Verify order is gone from book
     obs = abm.getLatestObservation();
-    depth = obs.assetOrderDepths.at("FOOD");
+    depth = obs.depth("FOOD");
     EXPECT_TRUE(depth.askBins.empty());
 }
 
@@ -271,11 +280,8 @@ TEST_F(ABMTest, MultipleAssetsNoCrossTalk) {
     ASSERT_EQ(pWaterCons->matches.size(), 1);
 
     // Check assets in match details
-    EXPECT_EQ(pFoodProd->matches[0].buyer.asset, "FOOD");
-    EXPECT_EQ(pFoodProd->matches[0].seller.asset, "FOOD");
-    
-    EXPECT_EQ(pWaterProd->matches[0].buyer.asset, "WATER");
-    EXPECT_EQ(pWaterProd->matches[0].seller.asset, "WATER");
+    EXPECT_EQ(pFoodProd->matches[0].asset, "FOOD");
+    EXPECT_EQ(pWaterProd->matches[0].asset, "WATER");
 
     // Verify correct partners (no cross-talk)
     EXPECT_EQ(pFoodProd->matches[0].buyer.traderId, pFoodCons->traderId);
@@ -409,3 +415,332 @@ TEST_F(ABMTest, AgentReceivesCorrectTickOnMatch) {
     EXPECT_TRUE(producer->orderPlacedCalled);
     EXPECT_EQ(producer->lastOrderPlacedTick.raw(), 2);
 }
+
+class MockDayTraderAgent : public Agent {
+public:
+    std::vector<long> canceled;
+    MockDayTraderAgent(long id) : Agent(id) {}
+    Action policy(const Observation& obs) override {
+        if(obs.time == tick(0)){
+            Order o("FOOD", Side::BUY, OrdType::LIMIT, 100, 1, 0, DAY);
+            return Action(o);
+        }
+        return Action();
+    }
+    void orderCanceled(long orderId, tick now) override {
+        canceled.push_back(orderId);
+    }
+};
+
+TEST_F(ABMTest, DayOrdersExpireAtEndOfStep) {
+    auto trader = std::make_unique<MockDayTraderAgent>(0);
+    MockDayTraderAgent* pTrader = trader.get();
+    abm.addAgent(std::move(trader));
+
+    abm.simStep();
+
+    EXPECT_EQ(pTrader->canceled.size(), 1);
+    EXPECT_TRUE(abm.getLatestObservation().spread("FOOD").bidsMissing);
+    EXPECT_EQ(abm.getNumOpenOrders(), 0);
+}
+
+class MockLastWillAgent : public Agent {
+public:
+    long placed = 0;
+    MockLastWillAgent(long id) : Agent(id) {}
+    Action policy(const Observation& obs) override {
+        if(obs.time == tick(0)){
+            Order o("FOOD", Side::SELL, OrdType::LIMIT, 100, 1);
+            return Action(o);
+        }
+        return Action();
+    }
+    void orderPlaced(long orderId, tick now) override {
+        placed = orderId;
+    }
+    Action lastWill(const Observation& obs) override {
+        return Action(placed);
+    }
+};
+
+TEST_F(ABMTest, LastWillCancelsShowInObservation) {
+    abm.addAgent(std::make_unique<MockLastWillAgent>(0));
+
+    abm.simStep();
+    ASSERT_FALSE(abm.getLatestObservation().spread("FOOD").asksMissing);
+
+    MockSelector selector(0);
+    abm.removeAgents(selector);
+    EXPECT_TRUE(abm.getLatestObservation().spread("FOOD").asksMissing);
+}
+
+TEST_F(ABMTest, AuctionIntervalDelaysMatching) {
+    abm.setAuctionInterval(2);
+
+    auto producer = std::make_unique<MockProducerAgent>(0);
+    auto consumer = std::make_unique<MockConsumerAgent>(0);
+    MockProducerAgent* pProducer = producer.get();
+    MockConsumerAgent* pConsumer = consumer.get();
+    abm.addAgent(std::move(producer));
+    abm.addAgent(std::move(consumer));
+
+    // Orders collect during the first step
+    abm.simStep();
+    EXPECT_TRUE(pProducer->matches.empty());
+    EXPECT_EQ(abm.getLatestObservation().bids("FOOD").size(), 1);
+
+    // And cross at the end of the second
+    abm.simStep();
+    ASSERT_EQ(pProducer->matches.size(), 1);
+    ASSERT_EQ(pConsumer->matches.size(), 1);
+    EXPECT_EQ(pConsumer->matches[0].price, 100);
+}
+
+class MockRandomTraderAgent : public Agent {
+public:
+    std::mt19937 rng;
+    std::vector<long> fills;
+    long lastPlaced = 0;
+    MockRandomTraderAgent(long seed) : Agent(0), rng(seed) {}
+    Action policy(const Observation& obs) override {
+        std::uniform_int_distribution<int> price(95, 105);
+        Side side = rng() % 2 == 0 ? BUY : SELL;
+        OrdType type = rng() % 3 == 0 ? MARKET : LIMIT;
+        Order o(rng() % 2 == 0 ? "FOOD" : "WOOD", side, type, type == LIMIT ? price(rng) : 0, 1 + rng() % 3);
+        if(lastPlaced > 0 && rng() % 4 == 0){
+            return Action(o, lastPlaced);
+        }
+        return Action(o);
+    }
+    void orderPlaced(long orderId, tick now) override {
+        lastPlaced = orderId;
+    }
+    void matchFound(const Match& match, tick now) override {
+        fills.push_back(match.buyer.ordId);
+        fills.push_back(match.seller.ordId);
+        fills.push_back(match.price);
+        fills.push_back(match.qty);
+    }
+};
+
+TEST(ABMPolicyThreadsTest, SameRunForAnyThreadCount) {
+    auto run = [](size_t numThreads){
+        ABM abm;
+        abm.setPolicyThreads(numThreads);
+        EXPECT_EQ(abm.getPolicyThreads(), numThreads);
+
+        std::vector<MockRandomTraderAgent*> traders;
+        for(long i = 0; i < 200; ++i){
+            auto trader = std::make_unique<MockRandomTraderAgent>(i);
+            traders.push_back(trader.get());
+            abm.addAgent(std::move(trader));
+        }
+        for(int step = 0; step < 20; ++step){
+            abm.simStep();
+        }
+
+        std::vector<long> fills;
+        for(auto* trader : traders){
+            fills.insert(fills.end(), trader->fills.begin(), trader->fills.end());
+        }
+        fills.push_back((long)abm.getNumOpenOrders());
+        return fills;
+    };
+
+    auto serial = run(1);
+    EXPECT_GT(serial.size(), 1u);
+    EXPECT_EQ(serial, run(2));
+    EXPECT_EQ(serial, run(4));
+}
+
+class MockBatchBuyerAgent : public Agent {
+public:
+    std::vector<size_t> batchSizes;
+    std::vector<unsigned long> seqs;
+    MockBatchBuyerAgent(long id) : Agent(id) {}
+    Action policy(const Observation& obs) override {
+        // A bid at a new price every step, so three steps leave three levels
+        if(obs.time.raw() < 3){
+            Order o("FOOD", Side::BUY, OrdType::LIMIT, 100 + obs.time.raw(), 1);
+            return Action(o);
+        }
+        return Action();
+    }
+    void matchesFound(MatchSpan fills, tick now) override {
+        batchSizes.push_back(fills.size());
+        for(const Match& match : fills){
+            seqs.push_back(match.seq);
+        }
+    }
+};
+
+class MockLateSellerAgent : public Agent {
+public:
+    std::vector<Match> matches;
+    MockLateSellerAgent(long id) : Agent(id) {}
+    Action policy(const Observation& obs) override {
+        if(obs.time == tick(3)){
+            Order o("FOOD", Side::SELL, OrdType::MARKET, 0, 3);
+            return Action(o);
+        }
+        return Action();
+    }
+    void matchFound(const Match& match, tick now) override {
+        matches.push_back(match);
+    }
+};
+
+TEST_F(ABMTest, FillsArriveInOneBatchPerAgent) {
+    auto buyer = std::make_unique<MockBatchBuyerAgent>(0);
+    auto seller = std::make_unique<MockLateSellerAgent>(0);
+    MockBatchBuyerAgent* pBuyer = buyer.get();
+    MockLateSellerAgent* pSeller = seller.get();
+    abm.addAgent(std::move(buyer));
+    abm.addAgent(std::move(seller));
+
+    for(int step = 0; step < 4; ++step){
+        abm.simStep();
+    }
+
+    ASSERT_EQ(pBuyer->batchSizes, std::vector<size_t>{3});
+    EXPECT_EQ(pBuyer->seqs, (std::vector<unsigned long>{1, 2, 3}));
+
+    // The default batch hands each fill to matchFound
+    ASSERT_EQ(pSeller->matches.size(), 3);
+    EXPECT_EQ(pSeller->matches[0].price, 102);
+}
+
+TEST_F(ABMTest, FillsForRemovedAgentsAreDropped) {
+    auto buyer = std::make_unique<MockBatchBuyerAgent>(0);
+    auto seller = std::make_unique<MockLateSellerAgent>(0);
+    MockLateSellerAgent* pSeller = seller.get();
+    abm.addAgent(std::move(buyer));  // ID 1
+    abm.addAgent(std::move(seller)); // ID 2
+
+    for(int step = 0; step < 3; ++step){
+        abm.simStep();
+    }
+
+    // The buyer leaves its bids behind
+    struct DropBuyer : AgentSelector {
+        bool keepThis(const std::unique_ptr<Agent>& agent) override { return agent->traderId != 1; }
+    } dropBuyer;
+    abm.removeAgents(dropBuyer);
+    EXPECT_EQ(abm.getNumAgents(), 1);
+
+    abm.simStep();
+    EXPECT_EQ(pSeller->matches.size(), 3);
+}
+
+TEST_F(ABMTest, DepthLevelsLimitObservedDepth) {
+    abm.addAgent(std::make_unique<MockBatchBuyerAgent>(0));
+    abm.addAgent(std::make_unique<MockProducerAgent>(0, "WOOD"));
+    for(int step = 0; step < 3; ++step){
+        abm.simStep();
+    }
+    EXPECT_EQ(abm.getLatestObservation().bids("FOOD").size(), 3);
+
+    // Only spreads, except where asked for
+    abm.setDepthLevels(0);
+    abm.setDepthLevels("FOOD", 2);
+    const Observation& obs = abm.getLatestObservation();
+    ASSERT_EQ(obs.bids("FOOD").size(), 2);
+    EXPECT_EQ(obs.bids("FOOD")[0].price, 102);
+    EXPECT_FALSE(obs.spread("FOOD").bidsMissing);
+    EXPECT_TRUE(obs.hasBook("WOOD"));
+    EXPECT_TRUE(obs.asks("WOOD").empty());
+}
+
+/// @brief Acts out a script keyed by step. Each entry sees the ids of the agent's orders placed so far
+class ScriptedAgent : public Agent {
+public:
+    std::vector<long> placed;
+    std::map<tick::rep, std::function<Action(const std::vector<long>&)>> script;
+
+    ScriptedAgent() : Agent(0) {}
+
+    Action policy(const Observation& obs) override {
+        auto step = script.find(obs.time.raw());
+        return step == script.end() ? Action() : step->second(placed);
+    }
+    void orderPlaced(long orderId, tick now) override {
+        placed.push_back(orderId);
+    }
+};
+
+Order scriptedOrder(const std::string& asset, Side side, OrdType type, unsigned int qty, unsigned short price,
+    TimeInForce tif = GTC) {
+    return Order(asset, side, type, price, qty, 0, tif);
+}
+
+TEST_F(ABMTest, CancelIndexFollowsOrdersAcrossBooks) {
+    auto foodSeller = std::make_unique<ScriptedAgent>();
+    auto woodSeller = std::make_unique<ScriptedAgent>();
+    auto buyer = std::make_unique<ScriptedAgent>();
+    ScriptedAgent& food = *foodSeller;
+    ScriptedAgent& wood = *woodSeller;
+
+    food.script[0] = [](const std::vector<long>&) {
+        Order order = scriptedOrder("FOOD", SELL, LIMIT, 5, 100);
+        return Action(order);
+    };
+    wood.script[0] = [](const std::vector<long>&) {
+        Order order = scriptedOrder("WOOD", SELL, LIMIT, 3, 50);
+        return Action(order);
+    };
+    // Cancel on FOOD while WOOD has a resting order
+    food.script[1] = [](const std::vector<long>& placed) { return Action(placed.at(0)); };
+    // The same id again, then an id nobody has
+    food.script[2] = [](const std::vector<long>& placed) { return Action(placed.at(0)); };
+    food.script[3] = [](const std::vector<long>&) { return Action(999999L); };
+    // Partial fill, then the rest
+    buyer->script[4] = [](const std::vector<long>&) {
+        Order order = scriptedOrder("WOOD", BUY, MARKET, 1, 0);
+        return Action(order);
+    };
+    buyer->script[5] = [](const std::vector<long>&) {
+        Order order = scriptedOrder("WOOD", BUY, MARKET, 2, 0);
+        return Action(order);
+    };
+    // Cancel after the fill
+    wood.script[6] = [](const std::vector<long>& placed) { return Action(placed.at(0)); };
+    // Gone again by the end of the step it was placed in
+    food.script[7] = [](const std::vector<long>&) {
+        Order order = scriptedOrder("FOOD", SELL, LIMIT, 1, 100, DAY);
+        return Action(order);
+    };
+
+    abm.addAgent(std::move(foodSeller));
+    abm.addAgent(std::move(woodSeller));
+    abm.addAgent(std::move(buyer));
+
+    abm.simStep();
+    EXPECT_EQ(2u, abm.getNumOpenOrders());
+
+    abm.simStep();
+    EXPECT_EQ(1u, abm.getNumOpenOrders());
+    EXPECT_TRUE(abm.getLatestObservation().spread("FOOD").asksMissing);
+    EXPECT_EQ(50, abm.getLatestObservation().spread("WOOD").lowestAsk);
+    EXPECT_EQ(3u, abm.getLatestObservation().spread("WOOD").lowestAskQty);
+
+    abm.simStep();
+    abm.simStep();
+    EXPECT_EQ(1u, abm.getNumOpenOrders());
+    EXPECT_EQ(3u, abm.getLatestObservation().spread("WOOD").lowestAskQty);
+
+    abm.simStep();
+    EXPECT_EQ(1u, abm.getNumOpenOrders());
+    EXPECT_EQ(2u, abm.getLatestObservation().spread("WOOD").lowestAskQty);
+
+    abm.simStep();
+    EXPECT_EQ(0u, abm.getNumOpenOrders());
+    EXPECT_TRUE(abm.getLatestObservation().spread("WOOD").asksMissing);
+
+    abm.simStep();
+    EXPECT_EQ(0u, abm.getNumOpenOrders());
+
+    abm.simStep();
+    EXPECT_EQ(2u, food.placed.size());
+    EXPECT_EQ(0u, abm.getNumOpenOrders());
+    EXPECT_TRUE(abm.getLatestObservation().spread("FOOD").asksMissing);
+}
@@ -13,7 +13,7 @@ TEST_F(ProducerTest, DecreasesWhenNoBids) {
     Observation obs;
     Spread spread;
     spread.bidsMissing = true;
-    obs.assetSpreads[asset] = spread;
+    obs.setBook(asset, spread);
     obs.time = tick(10);
     
     // Empty observation (no spreads)
@@ -31,7 +31,7 @@ TEST_F(ProducerTest, IncreasesQtyWhenBidHigh) {
     Spread spread;
     spread.bidsMissing = false;
     spread.highestBid = preferredPrice + 10; // Higher than preferred
-    obs.assetSpreads[asset] = spread;
+    obs.setBook(asset, spread);
 
     // First tick: qty starts at 1, should increase to 2?
     // Implementation: qtyPerTick default is 1. ++qtyPerTick happens before order creation.
@@ -53,7 +53,7 @@ TEST_F(ProducerTest, DecreasesQtyWhenBidLow) {
     Spread spread;
     spread.bidsMissing = false;
     spread.highestBid = preferredPrice - 10; // Lower than preferred
-    obs.assetSpreads[asset] = spread;
+    obs.setBook(asset, spread);
 
     // First tick: qty starts at 1. 1 -> 0?
     // Implementation: if (qtyPerTick > 0) --qtyPerTick;
@@ -134,9 +134,10 @@ TEST_F(ConsumerTest, ConsumingResetsHunger) {
     consumer.policy(obs1); // init
     
     // Simulate Match
-    Order buy(asset, BUY, LIMIT, 100, 1);
-    Order sell(asset, SELL, LIMIT, 100, 1);
-    Match match(buy, sell, 1);
+    Match match{};
+    match.qty = 1;
+    match.price = 100;
+    match.asset = asset;
     
     consumer.matchFound(match, tick(150));
     
@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "engine.h"
+#include "matcher.h"
+
+namespace {
+
+std::vector<Order> randomOrders(int count, int numSymbols, unsigned seed){
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> symbol(0, numSymbols - 1);
+    std::uniform_int_distribution<int> kind(0, 3);
+    std::uniform_int_distribution<int> price(90, 110);
+    std::uniform_int_distribution<int> qty(1, 20);
+
+    std::vector<Order> orders;
+    for(int i = 0; i < count; ++i){
+        Side side = kind(rng) % 2 == 0 ? BUY : SELL;
+        OrdType type = kind(rng) == 0 ? MARKET : LIMIT;
+        Order order("SYM" + std::to_string(symbol(rng)), side, type,
+            type == LIMIT ? price(rng) : 0, qty(rng));
+        order.ordId = i + 1;
+        order.traderId = i % 7;
+        orders.push_back(order);
+    }
+    return orders;
+}
+
+/// @brief Match ids and quantities, for comparing streams
+std::vector<long> flatten(const std::vector<Match>& matches){
+    std::vector<long> flat;
+    for(auto& m : matches){
+        flat.push_back(m.buyer.ordId);
+        flat.push_back(m.seller.ordId);
+        flat.push_back(m.qty);
+        flat.push_back(m.price);
+    }
+    return flat;
+}
+
+}
+
+TEST(ShardedEngineTest, EachSymbolMatchesLikeALoneMatcher){
+    auto orders = randomOrders(5000, 12, 42);
+
+    // Reference: one matcher per symbol on this thread
+    std::map<std::string, InMemoryNotifier> notifiers;
+    std::map<std::string, Matcher> matchers;
+    for(auto order : orders){
+        const std::string& name = order.asset.name();
+        if(matchers.find(name) == matchers.end()){
+            matchers.emplace(name, Matcher(&notifiers[name]));
+        }
+        matchers.at(name).addOrder(order);
+    }
+
+    ShardedEngine engine(3, 64);
+    for(auto& order : orders){
+        engine.addOrder(order);
+    }
+
+    std::map<std::string, std::vector<Match>> engineMatches;
+    size_t placed = 0;
+    unsigned long lastSeq = 0;
+    engine.drain([&](const EngineEvent& e){
+        EXPECT_GE(e.commandSeq, lastSeq);
+        lastSeq = e.commandSeq;
+        if(e.event.type == ORDER_PLACED) ++placed;
+        if(e.event.type == ORDER_MATCHED) engineMatches[e.event.match.asset.name()].push_back(e.event.match);
+    });
+
+    EXPECT_EQ(orders.size(), placed);
+    for(auto& [name, notifier] : notifiers){
+        EXPECT_EQ(flatten(notifier.matches), flatten(engineMatches[name])) << name;
+    }
+}
+
+TEST(ShardedEngineTest, OutputDoesNotDependOnWorkerCount){
+    auto orders = randomOrders(2000, 8, 7);
+
+    auto run = [&](size_t numWorkers){
+        ShardedEngine engine(numWorkers, 32);
+        std::vector<long> stream;
+        for(size_t i = 0; i < orders.size(); ++i){
+            engine.addOrder(orders[i]);
+            if(i % 10 == 0){
+                engine.cancelOrder(orders[i / 2].asset, orders[i / 2].ordId);
+            }
+        }
+        engine.drain([&](const EngineEvent& e){
+            stream.push_back((long)e.commandSeq);
+            stream.push_back(e.event.type);
+            stream.push_back(e.event.type == ORDER_MATCHED ? e.event.match.buyer.ordId : e.event.order.ordId);
+        });
+        return stream;
+    };
+
+    auto single = run(1);
+    EXPECT_FALSE(single.empty());
+    EXPECT_EQ(single, run(2));
+    EXPECT_EQ(single, run(5));
+}
+
+TEST(ShardedEngineTest, CancelIsReportedOnce){
+    ShardedEngine engine(2);
+    Order order("FOOD", BUY, LIMIT, 100, 5);
+    order.ordId = 9;
+
+    engine.addOrder(order);
+    engine.cancelOrder("FOOD", 9);
+    engine.cancelOrder("FOOD", 9);
+
+    std::vector<NotifierEventType> types;
+    engine.drain([&](const EngineEvent& e){ types.push_back(e.event.type); });
+
+    ASSERT_EQ(2u, types.size());
+    EXPECT_EQ(ORDER_PLACED, types[0]);
+    EXPECT_EQ(ORDER_CANCELED, types[1]);
+}
+
+TEST(ShardedEngineTest, CancelForAnUnknownSymbolDoesNotCreateABook){
+    ShardedEngine engine(2);
+    Order order("FOOD", BUY, LIMIT, 100, 5);
+    order.ordId = 1;
+    engine.addOrder(order);
+
+    engine.cancelOrder("NOPE", 1);
+    engine.cancelOrder("NADA", 2);
+
+    std::vector<NotifierEventType> types;
+    engine.drain([&](const EngineEvent& e){ types.push_back(e.event.type); });
+
+    EXPECT_EQ(std::vector<NotifierEventType>{ORDER_PLACED}, types);
+    EXPECT_EQ(1u, engine.numBooks());
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+#include "eventbus.h"
+#include "matcher.h"
+
+TEST(EventBusTest, EveryConsumerSeesEveryEventInOrder){
+    EventBus<long> bus(8);
+    size_t first = bus.subscribe();
+    size_t second = bus.subscribe();
+
+    for(long i = 0; i < 5; ++i){
+        bus.publish(i);
+    }
+
+    std::vector<long> seenByFirst;
+    EXPECT_EQ(5u, bus.poll(first, [&](const long& e){ seenByFirst.push_back(e); }));
+    EXPECT_EQ(0u, bus.poll(first, [&](const long& e){ seenByFirst.push_back(e); }));
+    EXPECT_EQ((std::vector<long>{0, 1, 2, 3, 4}), seenByFirst);
+
+    bus.publish(5);
+    std::vector<long> seenBySecond;
+    EXPECT_EQ(6u, bus.poll(second, [&](const long& e){ seenBySecond.push_back(e); }));
+    EXPECT_EQ(5, seenBySecond.back());
+}
+
+TEST(EventBusTest, CapacityRoundsUpToPowerOfTwo){
+    EventBus<int> bus(100);
+    EXPECT_EQ(128u, bus.capacity());
+}
+
+void runConsumersBehindSmallRing(WaitStrategy waitStrategy){
+    const long numEvents = 20000;
+    EventBus<long> bus(256, waitStrategy);
+    size_t fast = bus.subscribe();
+    size_t slow = bus.subscribe();
+
+    auto consume = [&](size_t consumer, std::vector<long>& seen, bool dawdle){
+        while(bus.process(consumer, [&](const long& e){ seen.push_back(e); })){
+            if(dawdle && seen.size() % 1000 == 0) std::this_thread::yield();
+        }
+    };
+
+    std::vector<long> seenByFast;
+    std::vector<long> seenBySlow;
+    std::thread fastThread(consume, fast, std::ref(seenByFast), false);
+    std::thread slowThread(consume, slow, std::ref(seenBySlow), true);
+
+    // The ring is far smaller than the stream, so the publisher has to wait on the slow consumer
+    for(long i = 0; i < numEvents; ++i){
+        ASSERT_TRUE(bus.publish(i));
+    }
+
+    // Consumers drain what's left before they stop
+    bus.halt();
+    fastThread.join();
+    slowThread.join();
+
+    ASSERT_EQ((size_t)numEvents, seenByFast.size());
+    ASSERT_EQ((size_t)numEvents, seenBySlow.size());
+    for(long i = 0; i < numEvents; ++i){
+        ASSERT_EQ(i, seenByFast[i]);
+        ASSERT_EQ(i, seenBySlow[i]);
+    }
+}
+
+TEST(EventBusTest, BackpressureWithBusySpin){
+    runConsumersBehindSmallRing(BUSY_SPIN);
+}
+
+TEST(EventBusTest, BackpressureWithYield){
+    runConsumersBehindSmallRing(YIELD);
+}
+
+TEST(EventBusTest, BackpressureWithBlock){
+    runConsumersBehindSmallRing(BLOCK);
+}
+
+TEST(EventBusTest, BusNotifierCarriesMatcherOutput){
+    EventBus<NotifierEvent> bus(64);
+    size_t consumer = bus.subscribe();
+    BusNotifier notifier(bus);
+    Matcher matcher(&notifier);
+
+    Order sell("TEST", SELL, LIMIT, 100, 5);
+    sell.ordId = 1;
+    Order buy("TEST", BUY, MARKET, 0, 5);
+    buy.ordId = 2;
+    Order bad("TEST", BUY, LIMIT, 100, 0);
+    bad.ordId = 3;
+
+    matcher.addOrder(sell);
+    matcher.addOrder(buy);
+    matcher.addOrder(bad);
+
+    std::vector<NotifierEvent> events;
+    bus.poll(consumer, [&](const NotifierEvent& e){ events.push_back(e); });
+
+    ASSERT_EQ(4u, events.size());
+    EXPECT_EQ(ORDER_PLACED, events[0].type);
+    EXPECT_EQ(1, events[0].order.ordId);
+    EXPECT_EQ(ORDER_PLACED, events[1].type);
+    EXPECT_EQ(ORDER_MATCHED, events[2].type);
+    EXPECT_EQ(2, events[2].match.buyer.ordId);
+    EXPECT_EQ(1, events[2].match.seller.ordId);
+    EXPECT_EQ(5u, events[2].match.qty);
+    EXPECT_EQ(ORDER_PLACEMENT_FAILED, events[3].type);
+    EXPECT_EQ(3, events[3].order.ordId);
+}
+
+TEST(EventBusTest, BusNotifierCountsEventsDroppedByAHaltedBus){
+    EventBus<NotifierEvent> bus(1);
+    bus.subscribe();
+    BusNotifier notifier(bus);
+    bus.halt();
+
+    Order order("TEST", BUY, LIMIT, 100, 5);
+    notifier.notifyOrderPlaced(order);
+    EXPECT_EQ(0u, notifier.dropped());
+
+    // The consumer never polled, so the one slot is still taken
+    notifier.notifyOrderPlaced(order);
+    EXPECT_EQ(1u, notifier.dropped());
+}
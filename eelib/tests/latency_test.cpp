@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+
+#include "engine.h"
+#include "latency.h"
+#include "matcher.h"
+
+TEST(LatencyHistogramTest, EmptyHistogramReportsZero){
+    LatencyHistogram histogram;
+    EXPECT_EQ(0u, histogram.count());
+    EXPECT_EQ(0u, histogram.percentile(50));
+    EXPECT_EQ(0u, histogram.min());
+    EXPECT_EQ(0.0, histogram.mean());
+}
+
+TEST(LatencyHistogramTest, PercentilesWithinBucketWidth){
+    LatencyHistogram histogram;
+    for(std::uint64_t nanos = 1; nanos <= 100000; ++nanos){
+        histogram.record(nanos);
+    }
+
+    EXPECT_EQ(100000u, histogram.count());
+    EXPECT_EQ(1u, histogram.min());
+    EXPECT_EQ(100000u, histogram.max());
+    EXPECT_DOUBLE_EQ(50000.5, histogram.mean());
+
+    // Buckets are at most 1/16th wider than the values in them, and never report below the true value
+    for(double percentile : {1.0, 50.0, 90.0, 99.0, 99.9}){
+        double exact = percentile / 100.0 * 100000;
+        EXPECT_GE((double)histogram.percentile(percentile), exact) << percentile;
+        EXPECT_LE((double)histogram.percentile(percentile), exact * (1 + 1.0 / 16)) << percentile;
+    }
+    EXPECT_EQ(100000u, histogram.percentile(100));
+}
+
+TEST(LatencyHistogramTest, SmallValuesAreExactAndTailsShow){
+    LatencyHistogram histogram;
+    for(int i = 0; i < 999; ++i){
+        histogram.record(20);
+    }
+    histogram.record(5000000);
+
+    EXPECT_EQ(20u, histogram.percentile(50));
+    EXPECT_EQ(20u, histogram.percentile(99.9));
+    EXPECT_EQ(5000000u, histogram.percentile(99.95));
+
+    LatencyHistogram other;
+    other.record(3);
+    histogram.merge(other);
+    EXPECT_EQ(1001u, histogram.count());
+    EXPECT_EQ(3u, histogram.min());
+
+    histogram.reset();
+    EXPECT_EQ(0u, histogram.count());
+}
+
+TEST(LatencyHistogramTest, MatcherRecordsByOrderType){
+    InMemoryNotifier notifier;
+    Matcher matcher(&notifier);
+    EXPECT_EQ(nullptr, matcher.getLatencies());
+
+    Order untimed("FOOD", SELL, LIMIT, 100, 5);
+    untimed.ordId = 1;
+    matcher.addOrder(untimed);
+
+    matcher.setLatencyTracking(true);
+    for(long id = 2; id <= 4; ++id){
+        Order limit("FOOD", SELL, LIMIT, 100, 5);
+        limit.ordId = id;
+        matcher.addOrder(limit);
+    }
+    Order market("FOOD", BUY, MARKET, 0, 3);
+    market.ordId = 5;
+    matcher.addOrder(market);
+    EXPECT_TRUE(matcher.cancelOrder(3));
+    EXPECT_FALSE(matcher.cancelOrder(99));
+
+    const OrderLatencies* latencies = matcher.getLatencies();
+    ASSERT_NE(nullptr, latencies);
+    EXPECT_EQ(3u, latencies->add(LIMIT).count());
+    EXPECT_EQ(1u, latencies->add(MARKET).count());
+    EXPECT_EQ(0u, latencies->add(STOP).count());
+    EXPECT_EQ(1u, latencies->cancel(LIMIT).count());
+    EXPECT_GT(latencies->add(LIMIT).max(), 0u);
+
+    matcher.setLatencyTracking(false);
+    EXPECT_EQ(nullptr, matcher.getLatencies());
+}
+
+TEST(LatencyHistogramTest, EngineAddsUpEveryBook){
+    ShardedEngine engine(2, 64, YIELD, true);
+    for(long id = 1; id <= 10; ++id){
+        Order order(id % 2 ? "FOOD" : "WOOD", BUY, LIMIT, 100, 1);
+        order.ordId = id;
+        engine.addOrder(order);
+    }
+    engine.cancelOrder("FOOD", 1);
+
+    OrderLatencies latencies = engine.latencies();
+    EXPECT_EQ(10u, latencies.add(LIMIT).count());
+    EXPECT_EQ(1u, latencies.cancel(LIMIT).count());
+
+    // Events are still there to drain
+    size_t events = 0;
+    engine.drain([&](const EngineEvent&){ ++events; });
+    EXPECT_EQ(11u, events);
+}
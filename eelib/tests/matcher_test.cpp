@@ -1,8 +1,14 @@
 #include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "matcher.h"
+#include "matcher_impl.h"
 #include "notifier.h"
+#include "observation.h"
 #include "order.h"
+#include "orderpool.h"
 
 struct MatcherTest : ::testing::Test {
     InMemoryNotifier notifier;
@@ -216,6 +222,40 @@ TEST_F(MatcherTest, MatchStopLimits_MatchesAndSpreadAreCorrect){
 
 }
 
+TEST_F(MatcherTest, Stops_PlacedPastTheTouchWaitForItToMove){
+    // Stops are only checked when the touch moves. One placed where the touch already reaches it waits for the next move
+    matcher.addOrder(newOrder(SELL, LIMIT, 10, 100));
+    matcher.addOrder(newOrder(BUY, LIMIT, 10, 90));
+
+    auto buyStop = newOrder(BUY, STOP, 4, 0, 95);             // lowest ask 100 >= 95
+    auto sellStopLimit = newOrder(SELL, STOPLIMIT, 3, 90, 92); // highest bid 90 <= 92
+    matcher.addOrder(buyStop);
+    matcher.addOrder(sellStopLimit);
+
+    EXPECT_EQ(0, notifier.matches.size());
+    auto spread = matcher.getSpread();
+    EXPECT_EQ(100, spread.lowestAsk);
+    EXPECT_EQ(10, spread.lowestAskQty);
+
+    // A new best ask moves the touch, and the buy stop still reached at 98 goes to the market
+    matcher.addOrder(newOrder(SELL, LIMIT, 2, 98));
+
+    ASSERT_EQ(2, notifier.matches.size());
+    EXPECT_EQ(buyStop.ordId, notifier.matches[0].buyer.ordId);
+    EXPECT_EQ(98, notifier.matches[0].price);
+    EXPECT_EQ(2, notifier.matches[0].qty);
+    EXPECT_EQ(buyStop.ordId, notifier.matches[1].buyer.ordId);
+    EXPECT_EQ(100, notifier.matches[1].price);
+    EXPECT_EQ(2, notifier.matches[1].qty);
+
+    // The bid hasn't moved, so the sell stop limit is still parked and out of the spread
+    spread = matcher.getSpread();
+    EXPECT_EQ(90, spread.highestBid);
+    EXPECT_EQ(100, spread.lowestAsk);
+    EXPECT_EQ(8, spread.lowestAskQty);
+    EXPECT_EQ(1, matcher.getOrderCounts().at(STOPLIMIT));
+}
+
 TEST_F(MatcherTest, SellStop_TriggersAfterWittlingBuys){
     // Place several buy limit orders
     Order buy1 = newOrder(BUY, LIMIT, 50, 100);
@@ -249,6 +289,331 @@ TEST_F(MatcherTest, SellStop_TriggersAfterWittlingBuys){
     EXPECT_TRUE(stopExecuted);
 }
 
+TEST_F(MatcherTest, SellStops_CascadeInOnePass){
+    matcher.addOrder(newOrder(BUY, LIMIT, 10, 100));
+    matcher.addOrder(newOrder(BUY, LIMIT, 10, 95));
+    matcher.addOrder(newOrder(BUY, LIMIT, 10, 90));
+    matcher.addOrder(newOrder(BUY, LIMIT, 10, 85));
+
+    auto stop95 = newOrder(SELL, STOP, 10, 0, 95);
+    auto stop90 = newOrder(SELL, STOP, 10, 0, 90);
+    auto farStop = newOrder(SELL, STOP, 10, 0, 50);
+    matcher.addOrder(stop95);
+    matcher.addOrder(stop90);
+    matcher.addOrder(farStop);
+    EXPECT_EQ(0, notifier.matches.size());
+
+    // Taking out 100 moves the bid to 95, which sets off the 95 stop, which moves it to 90, and so on
+    matcher.addOrder(newOrder(SELL, MARKET, 10));
+
+    ASSERT_EQ(3, notifier.matches.size());
+    EXPECT_EQ(stop95.ordId, notifier.matches[1].seller.ordId);
+    EXPECT_EQ(95, notifier.matches[1].price);
+    EXPECT_EQ(stop90.ordId, notifier.matches[2].seller.ordId);
+    EXPECT_EQ(90, notifier.matches[2].price);
+
+    auto spread = matcher.getSpread();
+    EXPECT_EQ(85, spread.highestBid);
+
+    auto counts = matcher.getOrderCounts();
+    EXPECT_EQ(1, counts.at(STOP));
+    EXPECT_TRUE(matcher.cancelOrder(farStop.ordId));
+    EXPECT_EQ(0, matcher.getOrderCounts().at(STOP));
+}
+
+TEST_F(MatcherTest, StopLimit_StaysOffTheBookUntilTriggered){
+    matcher.addOrder(newOrder(SELL, LIMIT, 10, 50));
+
+    auto stopLimit = newOrder(BUY, STOPLIMIT, 10, 60, 55);
+    matcher.addOrder(stopLimit);
+
+    auto spread = matcher.getSpread();
+    EXPECT_TRUE(spread.bidsMissing);
+    EXPECT_TRUE(matcher.getDepth().bidBins.empty());
+
+    // Ask moves up through the stop price
+    matcher.addOrder(newOrder(BUY, MARKET, 10));
+    matcher.addOrder(newOrder(SELL, LIMIT, 10, 70));
+
+    spread = matcher.getSpread();
+    EXPECT_FALSE(spread.bidsMissing);
+    EXPECT_EQ(60, spread.highestBid);
+    EXPECT_EQ(10u, spread.highestBidQty);
+
+    EXPECT_TRUE(matcher.cancelOrder(stopLimit.ordId));
+    EXPECT_TRUE(matcher.getSpread().bidsMissing);
+}
+
+TEST_F(MatcherTest, IocMarket_CancelsUnfilledRemainder){
+    matcher.addOrder(newOrder(SELL, LIMIT, 10, 100));
+
+    auto ioc = newOrder(BUY, MARKET, 25);
+    ioc.tif = IOC;
+    matcher.addOrder(ioc);
+
+    ASSERT_EQ(1, notifier.matches.size());
+    EXPECT_EQ(10, notifier.matches[0].qty);
+
+    ASSERT_EQ(1, notifier.canceledOrders.size());
+    EXPECT_EQ(ioc.ordId, notifier.canceledOrders[0].ordId);
+    EXPECT_EQ(10u, notifier.canceledOrders[0].fill);
+    EXPECT_EQ(0, matcher.getOrderCounts().at(MARKET));
+
+    // No liquidity at all
+    auto lonely = newOrder(SELL, MARKET, 5);
+    lonely.tif = IOC;
+    matcher.addOrder(lonely);
+    ASSERT_EQ(2, notifier.canceledOrders.size());
+    EXPECT_EQ(lonely.ordId, notifier.canceledOrders[1].ordId);
+}
+
+TEST_F(MatcherTest, UnknownEnums_AreRejectedWithoutTouchingTheBook){
+    auto resting = newOrder(SELL, LIMIT, 5, 100);
+    resting.tif = DAY;
+    matcher.addOrder(resting);
+    auto countsBefore = matcher.getOrderCounts();
+    auto spreadBefore = matcher.getSpread();
+
+    auto badType = newOrder(BUY, LIMIT, 1, 100);
+    badType.type = (OrdType)7;
+    auto badSide = newOrder(BUY, LIMIT, 1, 90);
+    badSide.side = (Side)0;
+    auto badTif = newOrder(BUY, LIMIT, 1, 90);
+    badTif.tif = (TimeInForce)2;
+    for(auto* bogus : {&badType, &badSide, &badTif}){
+        EXPECT_NO_THROW(matcher.addOrder(*bogus));
+    }
+
+    EXPECT_EQ(3, notifier.placementFailedOrders.size());
+    EXPECT_EQ(1, notifier.placedOrders.size());
+    EXPECT_EQ(countsBefore, matcher.getOrderCounts());
+    auto spread = matcher.getSpread();
+    EXPECT_EQ(spreadBefore.lowestAsk, spread.lowestAsk);
+    EXPECT_EQ(spreadBefore.lowestAskQty, spread.lowestAskQty);
+    EXPECT_TRUE(spread.bidsMissing);
+
+    // None of them got an id on the book, and expiring the day leaves them alone too
+    EXPECT_FALSE(matcher.cancelOrder(badType.ordId));
+    EXPECT_FALSE(matcher.cancelOrder(badSide.ordId));
+    EXPECT_FALSE(matcher.cancelOrder(badTif.ordId));
+    matcher.expireDayOrders();
+    EXPECT_EQ(1, notifier.canceledOrders.size());
+    EXPECT_EQ(resting.ordId, notifier.canceledOrders[0].ordId);
+}
+
+TEST_F(MatcherTest, FokMarket_FillsCompletelyOrNotAtAll){
+    matcher.addOrder(newOrder(BUY, LIMIT, 10, 100));
+    matcher.addOrder(newOrder(BUY, LIMIT, 10, 90));
+
+    auto tooBig = newOrder(SELL, MARKET, 25);
+    tooBig.tif = FOK;
+    matcher.addOrder(tooBig);
+
+    EXPECT_EQ(0, notifier.matches.size());
+    ASSERT_EQ(1, notifier.canceledOrders.size());
+    EXPECT_EQ(0u, notifier.canceledOrders[0].fill);
+    EXPECT_EQ(100, matcher.getSpread().highestBid);
+
+    auto fits = newOrder(SELL, MARKET, 20);
+    fits.tif = FOK;
+    matcher.addOrder(fits);
+
+    EXPECT_EQ(2, notifier.matches.size());
+    EXPECT_EQ(1, notifier.canceledOrders.size());
+    EXPECT_TRUE(matcher.getSpread().bidsMissing);
+}
+
+TEST_F(MatcherTest, IocLimit_IsRejected){
+    auto limit = newOrder(BUY, LIMIT, 10, 100);
+    limit.tif = IOC;
+    matcher.addOrder(limit);
+
+    EXPECT_EQ(1, notifier.placementFailedOrders.size());
+    EXPECT_EQ(0, notifier.placedOrders.size());
+}
+
+TEST_F(MatcherTest, ExpireDayOrders_CancelsOnlyRestingDayOrders){
+    auto dayBid = newOrder(BUY, LIMIT, 10, 100);
+    dayBid.tif = DAY;
+    auto gtcBid = newOrder(BUY, LIMIT, 10, 90);
+    auto dayMarket = newOrder(BUY, MARKET, 5);
+    dayMarket.tif = DAY;
+    auto filledDayAsk = newOrder(SELL, LIMIT, 5, 110);
+    filledDayAsk.tif = DAY;
+
+    matcher.addOrder(dayBid);
+    matcher.addOrder(gtcBid);
+    matcher.addOrder(filledDayAsk);
+    matcher.addOrder(dayMarket); // fills filledDayAsk
+    EXPECT_EQ(1, notifier.matches.size());
+
+    matcher.expireDayOrders();
+
+    ASSERT_EQ(1, notifier.canceledOrders.size());
+    EXPECT_EQ(dayBid.ordId, notifier.canceledOrders[0].ordId);
+    EXPECT_EQ(90, matcher.getSpread().highestBid);
+    EXPECT_FALSE(matcher.cancelOrder(dayBid.ordId));
+    EXPECT_TRUE(matcher.cancelOrder(gtcBid.ordId));
+}
+
+TEST_F(MatcherTest, AddOrders_RestsBatchThenMatchesOnce){
+    matcher.addOrder(newOrder(BUY, MARKET, 3)); // queued ahead of the batch
+
+    std::vector<Order> batch = {
+        newOrder(BUY, MARKET, 10),
+        newOrder(SELL, LIMIT, 4, 100),
+        newOrder(SELL, LIMIT, 0, 100), // rejected
+        newOrder(SELL, LIMIT, 6, 100),
+        newOrder(SELL, LIMIT, 5, 101),
+    };
+    matcher.addOrders(batch);
+
+    EXPECT_EQ(1, notifier.placementFailedOrders.size());
+    EXPECT_EQ(5, notifier.placedOrders.size());
+    EXPECT_EQ(batch[0].ordNum + 1, batch[1].ordNum);
+    EXPECT_EQ(batch[1].ordNum + 1, batch[3].ordNum);
+
+    // Older market first, then the batch market. Limits at one price fill in batch order
+    ASSERT_EQ(4, notifier.matches.size());
+    EXPECT_EQ(1, notifier.matches[0].buyer.ordId);
+    EXPECT_EQ(batch[1].ordId, notifier.matches[0].seller.ordId);
+    EXPECT_EQ(batch[0].ordId, notifier.matches[1].buyer.ordId);
+    EXPECT_EQ(batch[1].ordId, notifier.matches[1].seller.ordId);
+    EXPECT_EQ(batch[3].ordId, notifier.matches[2].seller.ordId);
+    EXPECT_EQ(batch[4].ordId, notifier.matches[3].seller.ordId);
+    EXPECT_EQ(3, notifier.matches[3].qty);
+
+    auto spread = matcher.getSpread();
+    EXPECT_EQ(101, spread.lowestAsk);
+    EXPECT_EQ(2u, spread.lowestAskQty);
+}
+
+TEST_F(MatcherTest, Uncross_TradesMaxVolumeAtOnePrice){
+    matcher.setMode(AUCTION);
+
+    matcher.addOrder(newOrder(BUY, LIMIT, 10, 105));
+    matcher.addOrder(newOrder(BUY, LIMIT, 10, 102));
+    matcher.addOrder(newOrder(BUY, LIMIT, 10, 99));
+    matcher.addOrder(newOrder(SELL, LIMIT, 5, 98));
+    matcher.addOrder(newOrder(SELL, LIMIT, 10, 101));
+    matcher.addOrder(newOrder(SELL, LIMIT, 10, 104));
+    auto sellMarket = newOrder(SELL, MARKET, 3);
+    matcher.addOrder(sellMarket);
+
+    // Nothing trades until the auction
+    EXPECT_EQ(0, notifier.matches.size());
+
+    // 101 and 102 both trade 18 with 2 bids left over, so the higher price wins. At 104 only 10 bids remain
+    auto result = matcher.uncross();
+    EXPECT_TRUE(result.crossed);
+    EXPECT_EQ(102, result.price);
+    EXPECT_EQ(18u, result.volume);
+
+    unsigned int traded = 0;
+    for(auto& m : notifier.matches){
+        EXPECT_EQ(102, m.price);
+        traded += m.qty;
+    }
+    EXPECT_EQ(18u, traded);
+
+    // Market first, then the best priced sell
+    EXPECT_EQ(sellMarket.ordId, notifier.matches[0].seller.ordId);
+
+    auto spread = matcher.getSpread();
+    EXPECT_EQ(102, spread.highestBid);
+    EXPECT_EQ(2u, spread.highestBidQty);
+    EXPECT_EQ(104, spread.lowestAsk);
+
+    // Book no longer crosses
+    EXPECT_FALSE(matcher.uncross().crossed);
+}
+
+TEST_F(MatcherTest, Uncross_TieBreaksOnTheImbalanceAtEachPrice){
+    matcher.setMode(AUCTION);
+
+    // 100 and 101 both trade 10 with 5 left over. At 100 that's 5 bids, at 101 it's 5 asks,
+    // so nothing pushes the price up to 101
+    matcher.addOrder(newOrder(BUY, LIMIT, 10, 101));
+    matcher.addOrder(newOrder(BUY, LIMIT, 5, 100));
+    matcher.addOrder(newOrder(SELL, LIMIT, 10, 100));
+    matcher.addOrder(newOrder(SELL, LIMIT, 5, 101));
+
+    auto result = matcher.uncross();
+    EXPECT_TRUE(result.crossed);
+    EXPECT_EQ(100, result.price);
+    EXPECT_EQ(10u, result.volume);
+}
+
+TEST_F(MatcherTest, Uncross_TieWithBuyersLeftOverTakesTheHigherPrice){
+    matcher.setMode(AUCTION);
+
+    // 100 and 101 both trade 5 with 5 bids left over
+    matcher.addOrder(newOrder(BUY, LIMIT, 10, 101));
+    matcher.addOrder(newOrder(SELL, LIMIT, 5, 100));
+
+    auto result = matcher.uncross();
+    EXPECT_TRUE(result.crossed);
+    EXPECT_EQ(101, result.price);
+    EXPECT_EQ(5u, result.volume);
+}
+
+TEST_F(MatcherTest, Uncross_CancelsIocLeftovers){
+    matcher.setMode(AUCTION);
+
+    auto ioc = newOrder(BUY, MARKET, 10);
+    ioc.tif = IOC;
+    matcher.addOrder(ioc);
+    matcher.addOrder(newOrder(SELL, LIMIT, 4, 100));
+    EXPECT_EQ(0, notifier.canceledOrders.size());
+
+    auto result = matcher.uncross();
+    EXPECT_EQ(4u, result.volume);
+    ASSERT_EQ(1, notifier.canceledOrders.size());
+    EXPECT_EQ(ioc.ordId, notifier.canceledOrders[0].ordId);
+    EXPECT_EQ(0, matcher.getOrderCounts().at(MARKET));
+
+    auto fok = newOrder(BUY, MARKET, 10);
+    fok.tif = FOK;
+    matcher.addOrder(fok);
+    EXPECT_EQ(1, notifier.placementFailedOrders.size());
+}
+
+TEST_F(MatcherTest, Match_CarriesPriceAggressorAndSequence){
+    auto ask1 = newOrder(SELL, LIMIT, 5, 100);
+    auto ask2 = newOrder(SELL, LIMIT, 5, 101);
+    auto buy  = newOrder(BUY, MARKET, 8);
+    buy.traderId = 77;
+
+    matcher.addOrder(ask1);
+    matcher.addOrder(ask2);
+    matcher.addOrder(buy);
+
+    ASSERT_EQ(2, notifier.matches.size());
+    const Match& first = notifier.matches[0];
+    const Match& second = notifier.matches[1];
+
+    EXPECT_EQ(buy.ordId, first.buyer.ordId);
+    EXPECT_EQ(77, first.buyer.traderId);
+    EXPECT_EQ(ask1.ordId, first.seller.ordId);
+    EXPECT_EQ(ask1.traderId, first.seller.traderId);
+    EXPECT_EQ(100, first.price);
+    EXPECT_EQ(5u, first.qty);
+    EXPECT_EQ(BUY, first.aggressor);
+    EXPECT_FALSE(first.buyerFilled);
+    EXPECT_TRUE(first.sellerFilled);
+    EXPECT_EQ("TEST", first.asset);
+
+    EXPECT_EQ(101, second.price);
+    EXPECT_EQ(3u, second.qty);
+    EXPECT_EQ(first.seq + 1, second.seq);
+    EXPECT_TRUE(second.buyerFilled);
+    EXPECT_FALSE(second.sellerFilled);
+
+    matcher.addOrder(newOrder(BUY, LIMIT, 1, 90));
+    matcher.addOrder(newOrder(SELL, MARKET, 1));
+    EXPECT_EQ(SELL, notifier.matches[2].aggressor);
+}
+
 TEST_F(MatcherTest, DumpOrdersTo_ExcludesCompletelyFilledOrders){
     // Place a buy limit that will be completely filled
     auto buyLimit1 = newOrder(BUY, LIMIT, 100, 10);
@@ -390,6 +755,63 @@ TEST_F(MatcherTest, GetDepth_ReturnsCumulativeBins){
     EXPECT_EQ(50u,  d.askBins[1].totalQty);  // cumulative at 120 = 20 + 30
 }
 
+TEST_F(MatcherTest, GetDepth_TopLevelsIntoReusedBuffer){
+    for(int i = 0; i < 10; ++i){
+        matcher.addOrder(newOrder(BUY, LIMIT, 10, 100 - i));
+        matcher.addOrder(newOrder(SELL, LIMIT, 10, 110 + i));
+    }
+
+    Depth d;
+    matcher.getDepth(d);
+    EXPECT_EQ(10u, d.bidBins.size());
+    const PriceBin* bidStorage = d.bidBins.data();
+
+    // Fewer levels overwrite the same buffers
+    matcher.getDepth(d, 3);
+    EXPECT_EQ(bidStorage, d.bidBins.data());
+    ASSERT_EQ(3u, d.bidBins.size());
+    ASSERT_EQ(3u, d.askBins.size());
+    EXPECT_EQ(98u, d.bidBins[2].price);
+    EXPECT_EQ(30u, d.bidBins[2].totalQty);
+    EXPECT_EQ(112u, d.askBins[2].price);
+
+    matcher.getDepth(d, 0);
+    EXPECT_TRUE(d.bidBins.empty());
+    EXPECT_TRUE(d.askBins.empty());
+}
+
+TEST_F(MatcherTest, GetDepth_FollowsFillsAndCancels){
+    auto bid1 = newOrder(BUY, LIMIT, 10, 100);
+    auto bid2 = newOrder(BUY, LIMIT, 20, 100);
+    auto bid3 = newOrder(BUY, LIMIT, 30, 90);
+
+    matcher.addOrder(bid1);
+    matcher.addOrder(bid2);
+    matcher.addOrder(bid3);
+
+    Depth d = matcher.getDepth();
+    ASSERT_EQ(2u, d.bidBins.size());
+    EXPECT_EQ(30u, d.bidBins[0].totalQty);
+    EXPECT_EQ(2u,  d.bidBins[0].numOrders);
+    EXPECT_EQ(60u, d.bidBins[1].totalQty);
+    EXPECT_EQ(1u,  d.bidBins[1].numOrders);
+
+    // Fill bid1 and part of bid2
+    matcher.addOrder(newOrder(SELL, MARKET, 15));
+    d = matcher.getDepth();
+    ASSERT_EQ(2u, d.bidBins.size());
+    EXPECT_EQ(15u, d.bidBins[0].totalQty);
+    EXPECT_EQ(1u,  d.bidBins[0].numOrders);
+    EXPECT_EQ(45u, d.bidBins[1].totalQty);
+
+    matcher.cancelOrder(bid2.ordId);
+    d = matcher.getDepth();
+    ASSERT_EQ(1u, d.bidBins.size());
+    EXPECT_EQ(90u, d.bidBins[0].price);
+    EXPECT_EQ(30u, d.bidBins[0].totalQty);
+    EXPECT_EQ(1u,  d.bidBins[0].numOrders);
+}
+
 TEST_F(MatcherTest, CanceledOrdersAreInvisibleInReflectedState){
     // Place orders that define the BBO
     auto buy = newOrder(BUY, LIMIT, 10, 100);
@@ -431,4 +853,310 @@ TEST_F(MatcherTest, CanceledOrdersAreInvisibleInReflectedState){
 
     depth = matcher.getDepth();
     EXPECT_TRUE(depth.askBins.empty());
-}
\ No newline at end of file
+}
+
+TEST_F(MatcherTest, Spread_TracksLiveQtyAtTouch){
+    auto bid1 = newOrder(BUY,  LIMIT, 10, 100);
+    auto bid2 = newOrder(BUY,  LIMIT, 15, 100);
+    auto bid3 = newOrder(BUY,  LIMIT, 20, 95);
+    auto ask1 = newOrder(SELL, LIMIT, 7,  110);
+
+    matcher.addOrder(bid1);
+    matcher.addOrder(bid2);
+    matcher.addOrder(bid3);
+    matcher.addOrder(ask1);
+
+    auto spread = matcher.getSpread();
+    EXPECT_EQ(100, spread.highestBid);
+    EXPECT_EQ(25u, spread.highestBidQty);
+    EXPECT_EQ(110, spread.lowestAsk);
+    EXPECT_EQ(7u,  spread.lowestAskQty);
+
+    // Partial fill of the oldest bid at the touch
+    matcher.addOrder(newOrder(SELL, MARKET, 4));
+    spread = matcher.getSpread();
+    EXPECT_EQ(100, spread.highestBid);
+    EXPECT_EQ(21u, spread.highestBidQty);
+
+    // Canceling the rest of the touch moves the bid down a level
+    matcher.cancelOrder(bid1.ordId);
+    spread = matcher.getSpread();
+    EXPECT_EQ(100, spread.highestBid);
+    EXPECT_EQ(15u, spread.highestBidQty);
+
+    matcher.cancelOrder(bid2.ordId);
+    spread = matcher.getSpread();
+    EXPECT_EQ(95, spread.highestBid);
+    EXPECT_EQ(20u, spread.highestBidQty);
+
+    // Canceling twice is harmless
+    matcher.cancelOrder(bid2.ordId);
+    spread = matcher.getSpread();
+    EXPECT_EQ(95, spread.highestBid);
+    EXPECT_EQ(20u, spread.highestBidQty);
+
+    // Sweeping the ask empties that side
+    matcher.addOrder(newOrder(BUY, MARKET, 7));
+    spread = matcher.getSpread();
+    EXPECT_TRUE(spread.asksMissing);
+    EXPECT_EQ(0u, spread.lowestAskQty);
+}
+
+TEST_F(MatcherTest, CancelOrder_RemovesFromMiddleOfLevel){
+    auto first  = newOrder(SELL, LIMIT, 10, 100);
+    auto middle = newOrder(SELL, LIMIT, 20, 100);
+    auto last   = newOrder(SELL, LIMIT, 30, 100);
+    auto stop   = newOrder(BUY, STOP, 5, 0, 500);
+
+    matcher.addOrder(first);
+    matcher.addOrder(middle);
+    matcher.addOrder(last);
+    matcher.addOrder(stop);
+
+    EXPECT_TRUE(matcher.cancelOrder(middle.ordId));
+    EXPECT_TRUE(matcher.cancelOrder(stop.ordId));
+
+    // Already gone, or never existed
+    EXPECT_FALSE(matcher.cancelOrder(middle.ordId));
+    EXPECT_FALSE(matcher.cancelOrder(stop.ordId));
+    EXPECT_FALSE(matcher.cancelOrder(12345));
+
+    std::vector<Order> dumped;
+    matcher.dumpOrdersTo(dumped);
+    ASSERT_EQ(2u, dumped.size());
+    EXPECT_EQ(first.ordId, dumped[0].ordId);
+    EXPECT_EQ(last.ordId, dumped[1].ordId);
+
+    auto spread = matcher.getSpread();
+    EXPECT_EQ(40u, spread.lowestAskQty);
+
+    // Remaining orders keep their time priority
+    matcher.addOrder(newOrder(BUY, MARKET, 40));
+    ASSERT_EQ(2u, notifier.matches.size());
+    EXPECT_EQ(first.ordId, notifier.matches[0].seller.ordId);
+    EXPECT_EQ(last.ordId, notifier.matches[1].seller.ordId);
+
+    // Filled orders can't be canceled
+    EXPECT_FALSE(matcher.cancelOrder(first.ordId));
+    EXPECT_TRUE(matcher.getSpread().asksMissing);
+}
+
+TEST_F(MatcherTest, Version_MovesOnlyWhenTheBookChanges){
+    unsigned long version = matcher.getVersion();
+
+    // Rejected orders and unknown cancels leave the book alone
+    matcher.addOrder(newOrder(BUY, LIMIT, 0, 100));
+    EXPECT_FALSE(matcher.cancelOrder(12345));
+    matcher.getDepth();
+    EXPECT_EQ(version, matcher.getVersion());
+
+    auto sell = newOrder(SELL, LIMIT, 10, 100);
+    matcher.addOrder(sell);
+    EXPECT_NE(version, matcher.getVersion());
+    version = matcher.getVersion();
+
+    matcher.addOrder(newOrder(BUY, MARKET, 4));
+    EXPECT_NE(version, matcher.getVersion());
+    version = matcher.getVersion();
+
+    EXPECT_TRUE(matcher.cancelOrder(sell.ordId));
+    EXPECT_NE(version, matcher.getVersion());
+}
+
+TEST(OrderPoolTest, ReleasedNodesAreReused){
+    OrderPool pool;
+    OrderQueue queue;
+
+    Order order("TEST", BUY, LIMIT, 100, 1);
+    OrderRef a = pool.acquire(order);
+    OrderRef b = pool.acquire(order);
+    OrderRef c = pool.acquire(order);
+    queue.pushBack(pool, a);
+    queue.pushBack(pool, b);
+    queue.pushBack(pool, c);
+
+    queue.remove(pool, b);
+    EXPECT_EQ(a, queue.front());
+    EXPECT_EQ(c, pool.node(a).next);
+    EXPECT_EQ(a, pool.node(c).prev);
+
+    pool.release(b);
+    EXPECT_EQ(b, pool.acquire(order));
+
+    queue.remove(pool, a);
+    queue.remove(pool, c);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(OrderPoolTest, HotAndColdHalvesRoundTrip){
+    OrderPool pool;
+
+    Order order("TEST", SELL, STOPLIMIT, 120, 30, 125);
+    order.traderId = 7;
+    order.ordId = 42;
+    order.ordNum = 3;
+    order.fill = 10;
+
+    OrderRef ref = pool.acquire(order);
+    EXPECT_EQ(20u, pool.hot(ref).unfilled());
+    EXPECT_EQ(7, pool.cold(ref).traderId);
+
+    Order back = pool.toOrder(ref);
+    EXPECT_EQ(order.traderId, back.traderId);
+    EXPECT_EQ(order.ordId, back.ordId);
+    EXPECT_EQ(order.ordNum, back.ordNum);
+    EXPECT_EQ(order.qty, back.qty);
+    EXPECT_EQ(order.fill, back.fill);
+    EXPECT_EQ(order.price, back.price);
+    EXPECT_EQ(order.stopPrice, back.stopPrice);
+    EXPECT_EQ(order.asset, back.asset);
+    EXPECT_EQ(order.side, back.side);
+    EXPECT_EQ(order.type, back.type);
+}
+
+TEST(SymbolTest, InternsNamesOnce){
+    Symbol a("FOOD");
+    Symbol b(std::string("FOOD"));
+    Symbol c("WATER");
+
+    EXPECT_EQ(a, b);
+    EXPECT_NE(a, c);
+    EXPECT_EQ(a.id(), b.id());
+    EXPECT_EQ("FOOD", a.name());
+    EXPECT_EQ(a, "FOOD");
+    EXPECT_EQ(a, Symbol::fromId(a.id()));
+    EXPECT_EQ(0u, Symbol().id());
+    EXPECT_LT(c.id(), Symbol::count());
+}
+
+TEST(SymbolTest, FindDoesNotIntern){
+    Symbol known("FOOD");
+    Symbol::rep count = Symbol::count();
+
+    EXPECT_EQ(known, Symbol::find("FOOD"));
+    EXPECT_EQ(Symbol(), Symbol::find("NEVER_INTERNED_SYMBOL"));
+    EXPECT_EQ(count, Symbol::count());
+
+    // Name lookups on an observation go through find
+    Observation observation;
+    EXPECT_FALSE(observation.hasBook("ALSO_NEVER_INTERNED"));
+    EXPECT_TRUE(observation.spread(std::string("ALSO_NEVER_INTERNED")).bidsMissing);
+    EXPECT_EQ(count, Symbol::count());
+}
+
+TEST(SymbolTest, NamesReadBackWhileOthersIntern){
+    std::vector<std::thread> threads;
+    std::vector<std::vector<Symbol>> made(4);
+    for(size_t t = 0; t < made.size(); ++t){
+        threads.emplace_back([&, t]{
+            for(int i = 0; i < 3000; ++i){
+                std::string name = "SYMTEST" + std::to_string(t) + "_" + std::to_string(i);
+                made[t].push_back(Symbol(name));
+                EXPECT_EQ(name, made[t].back().name());
+            }
+        });
+    }
+    for(auto& thread : threads) thread.join();
+
+    for(size_t t = 0; t < made.size(); ++t){
+        EXPECT_EQ("SYMTEST" + std::to_string(t) + "_2999", made[t].back().name());
+    }
+}
+
+struct LadderMatcherTest : MatcherTest {
+    LadderMatcher ladder{&notifier};
+};
+
+TEST_F(LadderMatcherTest, SpreadAndDepthAtDomainEdges){
+    auto lowBuy   = newOrder(BUY,  LIMIT, 10, 1);
+    auto highBuy  = newOrder(BUY,  LIMIT, 20, 63);
+    auto lowSell  = newOrder(SELL, LIMIT, 30, 64);
+    auto highSell = newOrder(SELL, LIMIT, 40, 65535);
+
+    ladder.addOrder(lowBuy);
+    ladder.addOrder(highBuy);
+    ladder.addOrder(lowSell);
+    ladder.addOrder(highSell);
+
+    auto spread = ladder.getSpread();
+    EXPECT_FALSE(spread.bidsMissing || spread.asksMissing);
+    EXPECT_EQ(63, spread.highestBid);
+    EXPECT_EQ(64, spread.lowestAsk);
+
+    Depth d = ladder.getDepth();
+    ASSERT_EQ(2u, d.bidBins.size());
+    EXPECT_EQ(63u, d.bidBins[0].price);
+    EXPECT_EQ(1u,  d.bidBins[1].price);
+    EXPECT_EQ(30u, d.bidBins[1].totalQty);
+    ASSERT_EQ(2u, d.askBins.size());
+    EXPECT_EQ(64u,    d.askBins[0].price);
+    EXPECT_EQ(65535u, d.askBins[1].price);
+    EXPECT_EQ(70u,    d.askBins[1].totalQty);
+}
+
+TEST_F(LadderMatcherTest, SweepMatchesSameOrdersAsMapBook){
+    InMemoryNotifier mapNotifier;
+    Matcher mapMatcher{&mapNotifier};
+
+    std::vector<Order> orders = {
+        newOrder(SELL, LIMIT, 10, 130),
+        newOrder(SELL, LIMIT, 10, 100),
+        newOrder(SELL, LIMIT, 10, 200),
+        newOrder(BUY,  LIMIT, 10, 90),
+        newOrder(BUY,  LIMIT, 10, 20),
+        newOrder(BUY,  MARKET, 25),   // sweeps 100, 130 and half of 200
+        newOrder(SELL, MARKET, 15),   // sweeps 90 and half of 20
+    };
+
+    for(auto order : orders){
+        Order copy = order;
+        ladder.addOrder(order);
+        mapMatcher.addOrder(copy);
+    }
+
+    ASSERT_EQ(5, notifier.matches.size());
+    ASSERT_EQ(mapNotifier.matches.size(), notifier.matches.size());
+    for(size_t i = 0; i < notifier.matches.size(); ++i){
+        EXPECT_EQ(mapNotifier.matches[i].buyer.ordId, notifier.matches[i].buyer.ordId);
+        EXPECT_EQ(mapNotifier.matches[i].seller.ordId, notifier.matches[i].seller.ordId);
+        EXPECT_EQ(mapNotifier.matches[i].qty, notifier.matches[i].qty);
+    }
+
+    auto spread = ladder.getSpread();
+    EXPECT_EQ(20, spread.highestBid);
+    EXPECT_EQ(200, spread.lowestAsk);
+}
+
+/// @brief Notifier that doesn't derive from INotifier at all
+struct CountingNotifier{
+    int placed = 0;
+    int failed = 0;
+    int canceled = 0;
+    long matchedQty = 0;
+
+    void notifyOrderPlaced(const Order& order){ ++placed; }
+    void notifyOrderPlacementFailed(const Order& order, std::string reason){ ++failed; }
+    void notifyOrderMatched(const Match& match){ matchedQty += match.qty; }
+    void notifyOrderCanceled(const Order& order){ ++canceled; }
+};
+
+TEST(StaticNotifierTest, MatcherCallsNotifierTypeDirectly){
+    CountingNotifier notifier;
+    BasicMatcher<LadderPriceLevels, CountingNotifier> matcher{&notifier};
+
+    Order sell("TEST", SELL, LIMIT, 100, 10);
+    sell.ordId = 1;
+    Order buy("TEST", BUY, MARKET, 0, 15, 0, IOC);
+    buy.ordId = 2;
+    Order bad("TEST", BUY, LIMIT, 100, 0);
+    bad.ordId = 3;
+
+    matcher.addOrder(sell);
+    matcher.addOrder(buy);
+    matcher.addOrder(bad);
+
+    EXPECT_EQ(2, notifier.placed);
+    EXPECT_EQ(1, notifier.failed);
+    EXPECT_EQ(1, notifier.canceled);
+    EXPECT_EQ(10, notifier.matchedQty);
+}
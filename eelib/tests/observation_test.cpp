@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include "observation.h"
+
+namespace {
+
+Depth makeDepth(size_t numBids, size_t numAsks, unsigned short mid){
+    Depth depth;
+    for(size_t i = 0; i < numBids; ++i){
+        depth.bidBins.push_back(PriceBin{(unsigned short)(mid - 1 - i), (unsigned int)(i + 1), 1});
+    }
+    for(size_t i = 0; i < numAsks; ++i){
+        depth.askBins.push_back(PriceBin{(unsigned short)(mid + 1 + i), (unsigned int)(i + 1), 1});
+    }
+    return depth;
+}
+
+void expectDepth(const Observation& obs, Symbol asset, const Depth& expected){
+    PriceBinSpan bids = obs.bids(asset);
+    PriceBinSpan asks = obs.asks(asset);
+    ASSERT_EQ(expected.bidBins.size(), bids.size()) << asset;
+    ASSERT_EQ(expected.askBins.size(), asks.size()) << asset;
+    for(size_t i = 0; i < bids.size(); ++i){
+        EXPECT_EQ(expected.bidBins[i].price, bids[i].price);
+        EXPECT_EQ(expected.bidBins[i].totalQty, bids[i].totalQty);
+    }
+    for(size_t i = 0; i < asks.size(); ++i){
+        EXPECT_EQ(expected.askBins[i].price, asks[i].price);
+        EXPECT_EQ(expected.askBins[i].totalQty, asks[i].totalQty);
+    }
+}
+
+}
+
+TEST(ObservationTest, UnknownAssetHasEmptyBook){
+    Observation obs;
+    EXPECT_FALSE(obs.hasBook("NOBOOK"));
+    EXPECT_TRUE(obs.spread("NOBOOK").bidsMissing);
+    EXPECT_TRUE(obs.spread("NOBOOK").asksMissing);
+    EXPECT_TRUE(obs.bids("NOBOOK").empty());
+    EXPECT_TRUE(obs.asks("NOBOOK").empty());
+}
+
+TEST(ObservationTest, BooksKeepTheirDepthAsOthersGrowAndShrink){
+    Observation obs;
+    Symbol food("FOOD");
+    Symbol wood("WOOD");
+    Symbol iron("IRON");
+
+    Spread spread;
+    spread.bidsMissing = false;
+    spread.highestBid = 99;
+
+    obs.setBook(food, spread, makeDepth(2, 3, 100));
+    obs.setBook(wood, Spread(), makeDepth(1, 0, 50));
+    obs.setBook(iron, Spread(), Depth());
+
+    EXPECT_TRUE(obs.hasBook(iron));
+    EXPECT_EQ(99, obs.spread(food).highestBid);
+    expectDepth(obs, food, makeDepth(2, 3, 100));
+    expectDepth(obs, wood, makeDepth(1, 0, 50));
+
+    // Growing moves a book to the end of the arena, shrinking reuses its space.
+    // Enough of both compacts the arena along the way
+    for(size_t round = 0; round < 20; ++round){
+        obs.setBook(wood, Spread(), makeDepth(round + 2, round % 3, 50));
+        obs.setBook(food, spread, makeDepth(round % 4, 1, 100));
+
+        expectDepth(obs, wood, makeDepth(round + 2, round % 3, 50));
+        expectDepth(obs, food, makeDepth(round % 4, 1, 100));
+        EXPECT_TRUE(obs.bids(iron).empty());
+    }
+
+    // Copies own their arena
+    Observation copy = obs;
+    obs.setBook(food, Spread(), Depth());
+    expectDepth(copy, food, makeDepth(19 % 4, 1, 100));
+    EXPECT_EQ(makeDepth(19 % 4, 1, 100).askBins.size(), copy.depth(food).askBins.size());
+}
@@ -0,0 +1,232 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include "abm.h"
+#include "population.h"
+
+namespace {
+
+struct MarketSpec{
+    std::string asset;
+    unsigned short maxPrice;
+    unsigned long appetite;
+    unsigned short preferedPrice;
+};
+
+const std::vector<MarketSpec> markets{
+    {"FOOD", 120, 3, 60},
+    {"WOOD", 90, 5, 40},
+    {"IRON", 200, 2, 150}
+};
+
+/// @brief Bids one lot every step and remembers the ids its orders got
+class IdRecordingAgent : public Agent{
+    public:
+        std::vector<long> placed;
+
+        IdRecordingAgent() : Agent(0){}
+
+        Action policy(const Observation& observation) override{
+            Order order("FOOD", BUY, LIMIT, 50, 1);
+            return Action{order};
+        }
+        void orderPlaced(long orderId, tick now) override{
+            placed.push_back(orderId);
+        }
+};
+
+/// @brief Places one order on its first step and remembers what happened to it
+class OneOrderAgent : public Agent{
+    Order order;
+    bool sent = false;
+
+    public:
+        std::vector<long> placed;
+        std::vector<long> canceled;
+        std::vector<long> fillTraderIds;
+
+        explicit OneOrderAgent(Order order_) : Agent(0), order(order_){}
+
+        Action policy(const Observation& observation) override{
+            if(sent) return Action();
+            sent = true;
+            return Action{order};
+        }
+        void orderPlaced(long orderId, tick now) override{
+            placed.push_back(orderId);
+        }
+        void orderCanceled(long orderId, tick now) override{
+            canceled.push_back(orderId);
+        }
+        void matchFound(const Match& match, tick now) override{
+            fillTraderIds.push_back(match.buyer.traderId == traderId ? match.seller.traderId : match.buyer.traderId);
+        }
+};
+
+/// @brief Lots of members that never trade
+class IdlePopulation : public Population{
+    size_t numMembers;
+
+    public:
+        explicit IdlePopulation(size_t numMembers_) : numMembers(numMembers_){}
+
+        size_t size() const override { return numMembers; }
+        void policies(const Observation& observation, size_t begin, size_t end, PopulationActions& actions) override{}
+};
+
+/// @brief Spread and depth of every market after each step
+std::vector<long> snapshot(const ABM& abm, const Observation& obs){
+    std::vector<long> state{(long)obs.time.raw(), (long)abm.getNumOpenOrders()};
+    for(auto& market : markets){
+        Spread spread = obs.spread(market.asset);
+        state.push_back(spread.bidsMissing ? -1 : spread.highestBid);
+        state.push_back(spread.highestBidQty);
+        for(auto& bin : obs.bids(market.asset)){
+            state.push_back(bin.price);
+            state.push_back(bin.totalQty);
+        }
+    }
+    return state;
+}
+
+}
+
+TEST(PopulationTest, BehavesLikeTheSameAgents){
+    const size_t consumersPerMarket = 40;
+    const size_t producersPerMarket = 5;
+
+    ABM agents;
+    for(auto& market : markets){
+        for(size_t i = 0; i < consumersPerMarket; ++i){
+            agents.addAgent(std::make_unique<Consumer>(0, market.asset, market.maxPrice + i, tick(market.appetite)));
+        }
+    }
+    for(auto& market : markets){
+        for(size_t i = 0; i < producersPerMarket; ++i){
+            agents.addAgent(std::make_unique<Producer>(0, market.asset, market.preferedPrice + i));
+        }
+    }
+
+    ABM populations;
+    auto consumers = std::make_unique<ConsumerPopulation>();
+    auto producers = std::make_unique<ProducerPopulation>();
+    for(auto& market : markets){
+        for(size_t i = 0; i < consumersPerMarket; ++i){
+            consumers->addMember(market.asset, market.maxPrice + i, tick(market.appetite));
+        }
+        for(size_t i = 0; i < producersPerMarket; ++i){
+            producers->addMember(market.asset, market.preferedPrice + i);
+        }
+    }
+    EXPECT_EQ(1, populations.addPopulation(std::move(consumers)));
+    EXPECT_EQ(1 + (long)(markets.size() * consumersPerMarket), populations.addPopulation(std::move(producers)));
+    EXPECT_EQ(agents.getNumAgents(), populations.getNumPopulationMembers());
+
+    // And again spread over threads
+    ABM threaded;
+    threaded.setPolicyThreads(3);
+    auto threadedConsumers = std::make_unique<ConsumerPopulation>();
+    auto threadedProducers = std::make_unique<ProducerPopulation>();
+    for(auto& market : markets){
+        for(size_t i = 0; i < consumersPerMarket; ++i){
+            threadedConsumers->addMember(market.asset, market.maxPrice + i, tick(market.appetite));
+        }
+        for(size_t i = 0; i < producersPerMarket; ++i){
+            threadedProducers->addMember(market.asset, market.preferedPrice + i);
+        }
+    }
+    threaded.addPopulation(std::move(threadedConsumers));
+    threaded.addPopulation(std::move(threadedProducers));
+
+    bool booksFilledUp = false;
+    for(int step = 0; step < 30; ++step){
+        agents.simStep();
+        populations.simStep();
+        threaded.simStep();
+
+        auto expected = snapshot(agents, agents.getLatestObservation());
+        ASSERT_EQ(expected, snapshot(populations, populations.getLatestObservation())) << "step " << step;
+        ASSERT_EQ(expected, snapshot(threaded, threaded.getLatestObservation())) << "step " << step;
+        booksFilledUp |= expected.size() > 2 + 2 * markets.size();
+    }
+    EXPECT_TRUE(booksFilledUp);
+}
+
+TEST(PopulationTest, AgentsAddedLaterGetIdsAfterThePopulation){
+    ABM abm;
+    auto consumers = std::make_unique<ConsumerPopulation>();
+    consumers->addMember("FOOD", 100, tick(2));
+    consumers->addMember("FOOD", 100, tick(2));
+
+    EXPECT_EQ(1, abm.addPopulation(std::move(consumers)));
+    EXPECT_EQ(3, abm.addAgent(std::make_unique<Producer>(0, "FOOD", 10)));
+    EXPECT_EQ(1u, abm.getNumAgents());
+    EXPECT_EQ(2u, abm.getNumPopulationMembers());
+
+    for(int step = 0; step < 5; ++step){
+        abm.simStep();
+    }
+    // Each consumer keeps one bid up, replacing it every step
+    EXPECT_LE(abm.getNumOpenOrders(), 2u);
+}
+
+TEST(PopulationTest, AgentsAfterAPopulationActAfterItsMembers){
+    // Same traders and ids, once all agents and once with the consumers as a population
+    ABM agents;
+    agents.addAgent(std::make_unique<Consumer>(0, "FOOD", 100, tick(2)));
+    agents.addAgent(std::make_unique<Consumer>(0, "FOOD", 100, tick(2)));
+    auto recorder = std::make_unique<IdRecordingAgent>();
+    IdRecordingAgent& expected = *recorder;
+    agents.addAgent(std::move(recorder));
+
+    ABM mixed;
+    auto consumers = std::make_unique<ConsumerPopulation>();
+    consumers->addMember("FOOD", 100, tick(2));
+    consumers->addMember("FOOD", 100, tick(2));
+    mixed.addPopulation(std::move(consumers));
+    auto mixedRecorder = std::make_unique<IdRecordingAgent>();
+    IdRecordingAgent& actual = *mixedRecorder;
+    mixed.addAgent(std::move(mixedRecorder));
+
+    for(int step = 0; step < 5; ++step){
+        agents.simStep();
+        mixed.simStep();
+    }
+    // Order ids are handed out as actions are applied, so they show the members went first
+    ASSERT_EQ(5u, expected.placed.size());
+    EXPECT_EQ(expected.placed, actual.placed);
+}
+
+TEST(PopulationTest, AgentsOnBothSidesOfABigPopulationGetTheirEvents){
+    ABM abm;
+    auto seller = std::make_unique<OneOrderAgent>(Order("FOOD", SELL, LIMIT, 50, 1));
+    OneOrderAgent& sellerRef = *seller;
+    EXPECT_EQ(1, abm.addAgent(std::move(seller)));
+
+    const size_t numMembers = 1000000;
+    EXPECT_EQ(2, abm.addPopulation(std::make_unique<IdlePopulation>(numMembers)));
+
+    auto buyer = std::make_unique<OneOrderAgent>(Order("FOOD", BUY, MARKET, 0, 1));
+    OneOrderAgent& buyerRef = *buyer;
+    long buyerId = abm.addAgent(std::move(buyer));
+    EXPECT_EQ(2 + (long)numMembers, buyerId);
+
+    Order dayOrder("FOOD", BUY, LIMIT, 10, 1);
+    dayOrder.tif = DAY;
+    auto dayTrader = std::make_unique<OneOrderAgent>(dayOrder);
+    OneOrderAgent& dayTraderRef = *dayTrader;
+    EXPECT_EQ(buyerId + 1, abm.addAgent(std::move(dayTrader)));
+
+    abm.simStep();
+    abm.simStep();
+
+    EXPECT_EQ(1u, sellerRef.placed.size());
+    EXPECT_EQ(1u, buyerRef.placed.size());
+    EXPECT_EQ(std::vector<long>{buyerId}, sellerRef.fillTraderIds);
+    EXPECT_EQ(std::vector<long>{1}, buyerRef.fillTraderIds);
+
+    ASSERT_EQ(1u, dayTraderRef.placed.size());
+    EXPECT_EQ(dayTraderRef.placed, dayTraderRef.canceled);
+    EXPECT_EQ(0u, abm.getNumOpenOrders());
+}
@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <vector>
+
+#include "threadpool.h"
+
+TEST(ThreadPoolTest, EveryIndexRunsOnce){
+    ThreadPool pool(4);
+    EXPECT_EQ(4u, pool.size());
+
+    for(size_t count : {0, 1, 3, 1000}){
+        std::vector<int> hits(count, 0);
+        pool.parallelFor(count, [&](size_t begin, size_t end){
+            for(size_t i = begin; i < end; ++i) ++hits[i];
+        });
+        EXPECT_EQ(std::vector<int>(count, 1), hits);
+    }
+}
+
+TEST(ThreadPoolTest, SingleThreadRunsOnCaller){
+    ThreadPool pool(1);
+    EXPECT_EQ(1u, pool.size());
+
+    std::vector<std::pair<size_t, size_t>> chunks;
+    pool.parallelFor(10, [&](size_t begin, size_t end){ chunks.emplace_back(begin, end); });
+    ASSERT_EQ(1u, chunks.size());
+    EXPECT_EQ(0u, chunks[0].first);
+    EXPECT_EQ(10u, chunks[0].second);
+}
+
+TEST(ThreadPoolTest, ExceptionReachesCaller){
+    ThreadPool pool(3);
+    EXPECT_THROW(pool.parallelFor(100, [](size_t begin, size_t end){
+        if(begin <= 50 && 50 < end) throw std::runtime_error("boom");
+    }), std::runtime_error);
+
+    // Still usable afterwards
+    size_t total = 0;
+    std::mutex mutex;
+    pool.parallelFor(100, [&](size_t begin, size_t end){
+        std::lock_guard<std::mutex> lock(mutex);
+        total += end - begin;
+    });
+    EXPECT_EQ(100u, total);
+}
@@ -0,0 +1,250 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "abm.h"
+#include "agent.h"
+#include "trace.h"
+
+namespace {
+
+std::string tracePath(const std::string& name){
+    return ::testing::TempDir() + name;
+}
+
+const std::vector<std::string> assets{"FOOD", "WOOD"};
+
+/// @brief Consumers and producers on every asset, run for a number of steps while tracing
+void runTraced(ABM& abm, const std::string& path, int steps){
+    for(auto& asset : assets){
+        for(unsigned short i = 0; i < 10; ++i){
+            abm.addAgent(std::make_unique<Consumer>(0, asset, 100 + i, tick(3)));
+            abm.addAgent(std::make_unique<Producer>(0, asset, 50 + i));
+        }
+    }
+
+    abm.startTrace(path);
+    for(int step = 0; step < steps; ++step){
+        abm.simStep();
+    }
+    abm.stopTrace();
+}
+
+/// @brief Leaves one GTC bid on the book in the first step
+class RestingBidAgent : public Agent{
+    public:
+        RestingBidAgent() : Agent(0){}
+
+        Action policy(const Observation& observation) override{
+            if(observation.time != tick(0)) return Action();
+            Order order("FOOD", BUY, LIMIT, 100, 1, 0, GTC);
+            return Action{order};
+        }
+};
+
+/// @brief Spread and bids of a replayed book, next to what the ABM observed for the asset
+void expectSameBook(const Observation& observation, Symbol asset, Matcher& book){
+    Spread observed = observation.spread(asset);
+    Spread replayed = book.getSpread();
+    EXPECT_EQ(observed.bidsMissing, replayed.bidsMissing) << asset;
+    EXPECT_EQ(observed.highestBid, replayed.highestBid) << asset;
+    EXPECT_EQ(observed.highestBidQty, replayed.highestBidQty) << asset;
+    EXPECT_EQ(observed.asksMissing, replayed.asksMissing) << asset;
+
+    Depth depth;
+    book.getDepth(depth);
+    auto bids = observation.bids(asset);
+    ASSERT_EQ(bids.size(), depth.bidBins.size()) << asset;
+    for(size_t i = 0; i < depth.bidBins.size(); ++i){
+        EXPECT_EQ(bids[i].price, depth.bidBins[i].price);
+        EXPECT_EQ(bids[i].totalQty, depth.bidBins[i].totalQty);
+    }
+}
+
+}
+
+TEST(TraceTest, RecordsAndReadsBack){
+    std::string path = tracePath("eelib_trace_records.bin");
+    {
+        TraceWriter writer(path);
+        writer.mode("FOOD", CONTINUOUS);
+        Order order("FOOD", SELL, STOPLIMIT, 95, 7, 100, DAY);
+        order.ordId = 12;
+        order.traderId = 3;
+        writer.order(order);
+        writer.submit("FOOD", 1);
+        writer.cancel("WOOD", 40);
+        writer.tickEnded(tick(5));
+        EXPECT_EQ(5u, writer.size());
+    }
+
+    TraceReplay replay(path);
+    ASSERT_EQ(5u, replay.size());
+    ASSERT_EQ(2u, replay.assets().size());
+    EXPECT_EQ("FOOD", replay.assets()[0]);
+    EXPECT_EQ("WOOD", replay.assets()[1]);
+
+    const TraceRecord* records = replay.begin();
+    EXPECT_EQ(TRACE_MODE, records[0].type);
+    Order read = replay.toOrder(records[1]);
+    EXPECT_EQ(12, read.ordId);
+    EXPECT_EQ(3, read.traderId);
+    EXPECT_EQ("FOOD", read.asset);
+    EXPECT_EQ(SELL, read.side);
+    EXPECT_EQ(STOPLIMIT, read.type);
+    EXPECT_EQ(95, read.price);
+    EXPECT_EQ(100, read.stopPrice);
+    EXPECT_EQ(7u, read.qty);
+    EXPECT_EQ(DAY, read.tif);
+    EXPECT_EQ(TRACE_SUBMIT, records[2].type);
+    EXPECT_EQ(1, records[2].ordId);
+    EXPECT_EQ(TRACE_CANCEL, records[3].type);
+    EXPECT_EQ(1u, records[3].asset);
+    EXPECT_EQ(40, records[3].ordId);
+    EXPECT_EQ(TRACE_TICK, records[4].type);
+    EXPECT_EQ(5, records[4].ordId);
+
+    std::remove(path.c_str());
+}
+
+TEST(TraceTest, RejectsMissingAndUnfinishedFiles){
+    EXPECT_THROW(TraceReplay(tracePath("eelib_trace_missing.bin")), std::runtime_error);
+
+    std::string path = tracePath("eelib_trace_unfinished.bin");
+    TraceWriter writer(path);
+    writer.tickEnded(tick(0));
+    EXPECT_THROW(TraceReplay{path}, std::runtime_error);
+    writer.close();
+    EXPECT_NO_THROW(TraceReplay{path});
+
+    std::remove(path.c_str());
+}
+
+TEST(TraceTest, ReplayRebuildsTheAbmBooks){
+    for(unsigned long auctionInterval : {0ul, 3ul}){
+        std::string path = tracePath("eelib_trace_abm.bin");
+        ABM abm;
+        abm.setAuctionInterval(auctionInterval);
+        runTraced(abm, path, 31);
+
+        TraceReplay replay(path);
+        InMemoryNotifier notifier;
+        std::vector<Matcher> books;
+        for(size_t i = 0; i < replay.assets().size(); ++i){
+            books.emplace_back(&notifier);
+        }
+        TraceReplayStats stats = replay.replay(books);
+
+        EXPECT_EQ(31u, stats.ticks);
+        EXPECT_GT(stats.orders, 0u);
+        EXPECT_GT(stats.cancels, 0u);
+        EXPECT_FALSE(notifier.matches.empty());
+        ASSERT_EQ(assets.size(), replay.assets().size());
+        for(size_t i = 0; i < replay.assets().size(); ++i){
+            EXPECT_EQ(auctionInterval > 0 ? AUCTION : CONTINUOUS, books[i].getMode());
+            expectSameBook(abm.getLatestObservation(), replay.assets()[i], books[i]);
+        }
+
+        // Replaying again gives exactly the same fills
+        InMemoryNotifier again;
+        std::vector<Matcher> freshBooks;
+        for(size_t i = 0; i < replay.assets().size(); ++i){
+            freshBooks.emplace_back(&again);
+        }
+        replay.replay(freshBooks);
+        ASSERT_EQ(notifier.matches.size(), again.matches.size());
+        for(size_t i = 0; i < notifier.matches.size(); ++i){
+            EXPECT_EQ(notifier.matches[i].buyer.ordId, again.matches[i].buyer.ordId);
+            EXPECT_EQ(notifier.matches[i].seller.ordId, again.matches[i].seller.ordId);
+            EXPECT_EQ(notifier.matches[i].price, again.matches[i].price);
+            EXPECT_EQ(notifier.matches[i].qty, again.matches[i].qty);
+        }
+
+        std::remove(path.c_str());
+    }
+}
+
+TEST(TraceTest, StopTraceIsSafeWithoutATrace){
+    ABM abm;
+    EXPECT_FALSE(abm.isTracing());
+    abm.stopTrace();
+    abm.startTrace(tracePath("eelib_trace_flag.bin"));
+    EXPECT_TRUE(abm.isTracing());
+    abm.stopTrace();
+    EXPECT_FALSE(abm.isTracing());
+    std::remove(tracePath("eelib_trace_flag.bin").c_str());
+}
+
+TEST(TraceTest, RejectsMalformedBatchesAndValues){
+    std::string path = tracePath("eelib_trace_malformed.bin");
+    Order food("FOOD", BUY, LIMIT, 100, 5);
+    Order wood("WOOD", BUY, LIMIT, 100, 5);
+
+    auto rejected = [&](const std::function<void(TraceWriter&)>& write){
+        {
+            TraceWriter writer(path);
+            write(writer);
+        }
+        bool threw = false;
+        try{
+            TraceReplay replay(path);
+        }
+        catch(const std::runtime_error&){
+            threw = true;
+        }
+        std::remove(path.c_str());
+        return threw;
+    };
+
+    EXPECT_FALSE(rejected([&](TraceWriter& writer){ writer.order(food); writer.submit("FOOD", 1); }));
+    // Orders of one batch on different assets
+    EXPECT_TRUE(rejected([&](TraceWriter& writer){ writer.order(food); writer.order(wood); writer.submit("FOOD", 2); }));
+    // A batch submitted to another asset than its orders
+    EXPECT_TRUE(rejected([&](TraceWriter& writer){ writer.order(food); writer.submit("WOOD", 1); }));
+
+    Order badSide = food;
+    badSide.side = (Side)7;
+    EXPECT_TRUE(rejected([&](TraceWriter& writer){ writer.order(badSide); writer.submit("FOOD", 1); }));
+    Order badType = food;
+    badType.type = (OrdType)0;
+    EXPECT_TRUE(rejected([&](TraceWriter& writer){ writer.order(badType); writer.submit("FOOD", 1); }));
+    Order badTif = food;
+    badTif.tif = (TimeInForce)2;
+    EXPECT_TRUE(rejected([&](TraceWriter& writer){ writer.order(badTif); writer.submit("FOOD", 1); }));
+    EXPECT_TRUE(rejected([&](TraceWriter& writer){ writer.mode("FOOD", (MatchingMode)3); }));
+}
+
+TEST(TraceTest, StartTraceRejectsBooksWithRestingOrders){
+    std::string path = tracePath("eelib_trace_resting.bin");
+    ABM abm;
+    abm.addAgent(std::make_unique<RestingBidAgent>());
+    abm.simStep();
+    ASSERT_GT(abm.getNumOpenOrders(), 0u);
+
+    EXPECT_THROW(abm.startTrace(path), std::logic_error);
+    EXPECT_FALSE(abm.isTracing());
+    std::remove(path.c_str());
+}
+
+TEST(TraceTest, RejectsARecordCountThatWrapsTheNamesOffset){
+    std::string path = tracePath("eelib_trace_wrapped.bin");
+    {
+        TraceWriter writer(path);
+        writer.tickEnded(tick(0));
+    }
+
+    // namesOffset stays what it was, and header + numRecords * 32 wraps around to it in 64 bits
+    std::FILE* file = std::fopen(path.c_str(), "r+b");
+    ASSERT_NE(nullptr, file);
+    TraceHeader header;
+    ASSERT_EQ(1u, std::fread(&header, sizeof(header), 1, file));
+    header.numRecords += std::uint64_t(1) << 59;
+    std::fseek(file, 0, SEEK_SET);
+    std::fwrite(&header, sizeof(header), 1, file);
+    std::fclose(file);
+
+    EXPECT_THROW(TraceReplay{path}, std::runtime_error);
+    std::remove(path.c_str());
+}
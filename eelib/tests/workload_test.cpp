@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include <memory>
+
+#include "matcher.h"
+#include "workload.h"
+
+namespace {
+
+bool sameCommand(const EngineCommand& a, const EngineCommand& b){
+    return a.type == b.type && a.seq == b.seq && a.order.ordId == b.order.ordId && a.order.traderId == b.order.traderId
+        && a.order.asset == b.order.asset && a.order.side == b.order.side && a.order.type == b.order.type
+        && a.order.price == b.order.price && a.order.stopPrice == b.order.stopPrice && a.order.qty == b.order.qty;
+}
+
+}
+
+TEST(WorkloadTest, SameSeedSameCommands){
+    for(WorkloadScenario scenario : {MARKET_MAKING, MOMENTUM_BURSTS, DEEP_BOOK, ZIPF_SYMBOLS}){
+        std::vector<EngineCommand> first = WorkloadGenerator(scenario, 42).generate(20000);
+        std::vector<EngineCommand> second = WorkloadGenerator(scenario, 42).generate(20000);
+        std::vector<EngineCommand> other = WorkloadGenerator(scenario, 43).generate(20000);
+
+        ASSERT_EQ(first.size(), second.size());
+        size_t differing = 0;
+        for(size_t i = 0; i < first.size(); ++i){
+            ASSERT_TRUE(sameCommand(first[i], second[i])) << scenarioName(scenario) << " command " << i;
+            if(!sameCommand(first[i], other[i])) ++differing;
+        }
+        EXPECT_GT(differing, first.size() / 2) << scenarioName(scenario);
+    }
+}
+
+TEST(WorkloadTest, KnownSequenceForSeed){
+    // Pins the stream, so a change to the generator that alters existing workloads shows up here
+    std::vector<EngineCommand> commands = WorkloadGenerator(MARKET_MAKING, 7).generate(1000);
+    unsigned long checksum = 0;
+    for(auto& command : commands){
+        checksum = checksum * 31 + command.type;
+        checksum = checksum * 31 + (unsigned long)command.order.ordId;
+        checksum = checksum * 31 + command.order.side;
+        checksum = checksum * 31 + command.order.type;
+        checksum = checksum * 31 + command.order.price;
+        checksum = checksum * 31 + command.order.qty;
+    }
+    EXPECT_EQ(3027384041178117443ul, checksum);
+}
+
+TEST(WorkloadTest, ScenarioNamesRoundTrip){
+    for(WorkloadScenario scenario : {MARKET_MAKING, MOMENTUM_BURSTS, DEEP_BOOK, ZIPF_SYMBOLS}){
+        WorkloadScenario parsed;
+        ASSERT_TRUE(scenarioFromName(scenarioName(scenario), parsed));
+        EXPECT_EQ(scenario, parsed);
+    }
+    WorkloadScenario parsed;
+    EXPECT_FALSE(scenarioFromName("bogus", parsed));
+}
+
+TEST(WorkloadTest, MarketMakingIsCancelHeavy){
+    std::vector<EngineCommand> commands = WorkloadGenerator(MARKET_MAKING, 1).generate(50000);
+
+    InMemoryNotifier notifier;
+    Matcher matcher(&notifier);
+    size_t cancels = 0;
+    size_t canceled = 0;
+    for(auto& command : commands){
+        if(command.type == ADD_ORDER){
+            EXPECT_EQ(command.seq, (unsigned long)command.order.ordId);
+        }
+        if(command.type == CANCEL_ORDER) ++cancels;
+        if(applyCommand(matcher, command) && command.type == CANCEL_ORDER) ++canceled;
+    }
+    EXPECT_GT(cancels, commands.size() * 4 / 10);
+    // Most cancels find their order still resting
+    EXPECT_GT(canceled, cancels / 2);
+}
+
+TEST(WorkloadTest, MomentumBurstsTriggerStops){
+    std::vector<EngineCommand> commands = WorkloadGenerator(MOMENTUM_BURSTS, 3).generate(100000);
+
+    InMemoryNotifier notifier;
+    LadderMatcher matcher(&notifier);
+    for(auto& command : commands){
+        applyCommand(matcher, command);
+    }
+
+    size_t stopsPlaced = 0;
+    for(auto& command : commands){
+        if(command.type == ADD_ORDER && command.order.type == STOP) ++stopsPlaced;
+    }
+    ASSERT_GT(stopsPlaced, 0u);
+
+    // Stops that traded were triggered by the flow
+    size_t stopFills = 0;
+    for(auto& match : notifier.matches){
+        for(long ordId : {match.buyer.ordId, match.seller.ordId}){
+            const EngineCommand& command = commands[ordId - 1];
+            if(command.order.type == STOP) ++stopFills;
+        }
+    }
+    EXPECT_GT(stopFills, stopsPlaced / 10);
+}
+
+TEST(WorkloadTest, DeepBookSpreadsOverManyLevels){
+    std::vector<EngineCommand> commands = WorkloadGenerator(DEEP_BOOK, 5).generate(50000);
+
+    InMemoryNotifier notifier;
+    Matcher matcher(&notifier);
+    for(auto& command : commands){
+        applyCommand(matcher, command);
+    }
+
+    Depth depth;
+    matcher.getDepth(depth, 1000);
+    EXPECT_GT(depth.bidBins.size(), 200u);
+    EXPECT_GT(depth.askBins.size(), 200u);
+}
+
+TEST(WorkloadTest, ZipfFavorsLowSymbols){
+    WorkloadGenerator workload(ZIPF_SYMBOLS, 11);
+    ASSERT_EQ(1000u, workload.symbols().size());
+
+    std::vector<size_t> perSymbol(workload.symbols().size(), 0);
+    for(auto& command : workload.generate(100000)){
+        ++perSymbol[workload.symbolIndex(command.order.asset)];
+    }
+
+    EXPECT_GT(perSymbol[0], perSymbol[1]);
+    EXPECT_GT(perSymbol[1], perSymbol[9]);
+    EXPECT_GT(perSymbol[9], perSymbol[999]);
+    // 1/k^1.1 over 1000 symbols gives the first about 1/6th of the flow
+    EXPECT_GT(perSymbol[0], 100000u / 10);
+    EXPECT_LT(perSymbol[0], 100000u / 4);
+}
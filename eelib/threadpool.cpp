@@ -0,0 +1,85 @@
+#include "threadpool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t numThreads){
+    for(size_t t = 1; t < numThreads; ++t){
+        threads.emplace_back([this]{ workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workReady.notify_all();
+    for(auto& thread : threads){
+        thread.join();
+    }
+}
+
+void ThreadPool::runChunks(){
+    while(true){
+        size_t begin = nextIndex.fetch_add(chunkSize, std::memory_order_relaxed);
+        if(begin >= jobSize) return;
+        size_t end = std::min(begin + chunkSize, jobSize);
+
+        try{
+            (*body)(begin, end);
+        }
+        catch(...){
+            std::lock_guard<std::mutex> lock(mutex);
+            if(!error) error = std::current_exception();
+        }
+    }
+}
+
+void ThreadPool::workerLoop(){
+    unsigned long seen = 0;
+    while(true){
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workReady.wait(lock, [&]{ return stopping || generation != seen; });
+            if(stopping) return;
+            seen = generation;
+        }
+
+        runChunks();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if(--busy == 0) workDone.notify_one();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& body_){
+    if(count == 0) return;
+    if(threads.empty()){
+        body_(0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        body = &body_;
+        jobSize = count;
+        // A few chunks per thread, so one slow chunk doesn't hold up the rest
+        chunkSize = std::max<size_t>(1, count / (size() * 4));
+        nextIndex.store(0, std::memory_order_relaxed);
+        error = nullptr;
+        busy = threads.size();
+        ++generation;
+    }
+    workReady.notify_all();
+
+    runChunks();
+
+    std::exception_ptr failure;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        workDone.wait(lock, [&]{ return busy == 0; });
+        body = nullptr;
+        failure = error;
+        error = nullptr;
+    }
+    if(failure) std::rethrow_exception(failure);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+Fixed set of threads for splitting a loop over an index range.
+
+parallelFor hands out chunks of the range to the pool threads and the calling thread, and returns once
+every chunk is done. Which thread runs which chunk changes from call to call, so bodies should write
+their results by index rather than in the order they run.
+
+One parallelFor at a time, from one thread.
+*/
+class ThreadPool{
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable workReady;
+    std::condition_variable workDone;
+
+    /// @brief Current job. Written under the mutex before generation moves on
+    const std::function<void(size_t, size_t)>* body = nullptr;
+    size_t jobSize = 0;
+    size_t chunkSize = 1;
+    std::atomic<size_t> nextIndex{0};
+
+    /// @brief Bumped for every job, so threads can tell a new job from the one they just finished
+    unsigned long generation = 0;
+    /// @brief Pool threads still working on the current job
+    size_t busy = 0;
+    bool stopping = false;
+    std::exception_ptr error;
+
+    void runChunks();
+    void workerLoop();
+
+    public:
+        /// @param numThreads threads working on each job, counting the caller. 0 and 1 both run everything on the caller
+        explicit ThreadPool(size_t numThreads);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /// @brief Threads working on each job, counting the caller
+        size_t size() const { return threads.size() + 1; }
+
+        /// @brief Call body(begin, end) over chunks covering [0, count), then wait for all of them.
+        /// The first exception thrown by a chunk is rethrown here once the others are done
+        void parallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& body);
+};
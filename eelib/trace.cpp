@@ -0,0 +1,262 @@
+#include "trace.h"
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char traceMagic[8] = {'E', 'E', 'T', 'R', 'A', 'C', 'E', 0};
+constexpr std::uint32_t traceVersion = 1;
+
+/// @brief Records buffered before a write
+constexpr size_t writeBatch = 4096;
+
+}
+
+// TraceWriter Implementation
+
+TraceWriter::TraceWriter(const std::string& path){
+    file = std::fopen(path.c_str(), "wb");
+    if(!file){
+        throw std::runtime_error("Can't open trace file " + path);
+    }
+    buffer.reserve(writeBatch);
+
+    // Placeholder until close knows the counts
+    TraceHeader header{};
+    std::fwrite(&header, sizeof(header), 1, file);
+}
+
+TraceWriter::~TraceWriter(){
+    try{
+        close();
+    }
+    catch(const std::exception&){
+        // Nothing to report to from a destructor
+    }
+}
+
+std::uint32_t TraceWriter::indexOf(Symbol asset){
+    auto found = assetIndex.find(asset);
+    if(found != assetIndex.end()){
+        return found->second;
+    }
+    std::uint32_t index = (std::uint32_t)names.size();
+    assetIndex.emplace(asset, index);
+    names.push_back(asset.name());
+    return index;
+}
+
+void TraceWriter::write(const TraceRecord& record){
+    buffer.push_back(record);
+    ++numRecords;
+    if(buffer.size() == writeBatch){
+        flush();
+    }
+}
+
+void TraceWriter::flush(){
+    if(!buffer.empty()){
+        std::fwrite(buffer.data(), sizeof(TraceRecord), buffer.size(), file);
+        buffer.clear();
+    }
+}
+
+void TraceWriter::order(const Order& order){
+    TraceRecord record{};
+    record.type = TRACE_ORDER;
+    record.ordId = order.ordId;
+    record.traderId = order.traderId;
+    record.qty = order.qty;
+    record.asset = indexOf(order.asset);
+    record.price = order.price;
+    record.stopPrice = order.stopPrice;
+    record.side = order.side;
+    record.ordType = order.type;
+    record.tif = order.tif;
+    write(record);
+}
+
+void TraceWriter::submit(Symbol asset, size_t batchSize){
+    TraceRecord record{};
+    record.type = TRACE_SUBMIT;
+    record.ordId = (std::int64_t)batchSize;
+    record.asset = indexOf(asset);
+    write(record);
+}
+
+void TraceWriter::cancel(Symbol asset, long ordId){
+    TraceRecord record{};
+    record.type = TRACE_CANCEL;
+    record.ordId = ordId;
+    record.asset = indexOf(asset);
+    write(record);
+}
+
+void TraceWriter::uncross(Symbol asset){
+    TraceRecord record{};
+    record.type = TRACE_UNCROSS;
+    record.asset = indexOf(asset);
+    write(record);
+}
+
+void TraceWriter::expire(Symbol asset){
+    TraceRecord record{};
+    record.type = TRACE_EXPIRE;
+    record.asset = indexOf(asset);
+    write(record);
+}
+
+void TraceWriter::mode(Symbol asset, MatchingMode mode){
+    TraceRecord record{};
+    record.type = TRACE_MODE;
+    record.asset = indexOf(asset);
+    record.tif = mode;
+    write(record);
+}
+
+void TraceWriter::tickEnded(tick step){
+    TraceRecord record{};
+    record.type = TRACE_TICK;
+    record.ordId = step.raw();
+    write(record);
+}
+
+void TraceWriter::close(){
+    if(!file) return;
+    flush();
+
+    TraceHeader header{};
+    std::memcpy(header.magic, traceMagic, sizeof(traceMagic));
+    header.version = traceVersion;
+    header.recordSize = sizeof(TraceRecord);
+    header.numRecords = numRecords;
+    header.namesOffset = sizeof(TraceHeader) + numRecords * sizeof(TraceRecord);
+    header.numAssets = names.size();
+
+    for(auto& name : names){
+        std::uint32_t nameLength = (std::uint32_t)name.size();
+        std::fwrite(&nameLength, sizeof(nameLength), 1, file);
+        std::fwrite(name.data(), 1, name.size(), file);
+    }
+
+    std::fseek(file, 0, SEEK_SET);
+    std::fwrite(&header, sizeof(header), 1, file);
+
+    bool failed = std::ferror(file) != 0;
+    failed |= std::fclose(file) != 0;
+    file = nullptr;
+    if(failed){
+        throw std::runtime_error("Failed writing trace file");
+    }
+}
+
+// TraceReplay Implementation
+
+TraceReplay::TraceReplay(const std::string& path){
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0){
+        throw std::runtime_error("Can't open trace file " + path);
+    }
+    struct stat info;
+    if(::fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(TraceHeader)){
+        ::close(fd);
+        throw std::runtime_error("Not a trace file: " + path);
+    }
+    length = (size_t)info.st_size;
+
+    void* mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(mapping == MAP_FAILED){
+        throw std::runtime_error("Can't map trace file " + path);
+    }
+    data = (const unsigned char*)mapping;
+    ::madvise(mapping, length, MADV_SEQUENTIAL);
+
+    auto fail = [&](const std::string& reason){
+        ::munmap((void*)data, length);
+        throw std::runtime_error(reason + ": " + path);
+    };
+
+    const TraceHeader& header = *(const TraceHeader*)data;
+    if(std::memcmp(header.magic, traceMagic, sizeof(traceMagic)) != 0 || header.version != traceVersion ||
+        header.recordSize != sizeof(TraceRecord)){
+        fail("Not a trace file, or from another version");
+    }
+    // Bound the count before multiplying, so a crafted count can't wrap the product around to a plausible offset
+    if(header.numRecords > (length - sizeof(TraceHeader)) / sizeof(TraceRecord) ||
+        header.namesOffset != sizeof(TraceHeader) + header.numRecords * sizeof(TraceRecord) || header.namesOffset > length){
+        fail("Trace file is truncated or wasn't closed");
+    }
+    records_ = (const TraceRecord*)(data + sizeof(TraceHeader));
+    numRecords = (size_t)header.numRecords;
+
+    size_t offset = (size_t)header.namesOffset;
+    for(std::uint64_t i = 0; i < header.numAssets; ++i){
+        std::uint32_t nameLength;
+        if(offset + sizeof(nameLength) > length) fail("Trace file is truncated");
+        std::memcpy(&nameLength, data + offset, sizeof(nameLength));
+        offset += sizeof(nameLength);
+        if(offset + nameLength > length) fail("Trace file is truncated");
+        assets_.push_back(Symbol(std::string((const char*)data + offset, nameLength)));
+        offset += nameLength;
+    }
+
+    // Check every record once, so replay can trust them. This also pulls the file into memory ahead of a replay
+    size_t pendingOrders = 0;
+    std::uint32_t batchAsset = 0;
+    for(size_t i = 0; i < numRecords; ++i){
+        const TraceRecord& record = records_[i];
+        if(record.type < TRACE_ORDER || record.type > TRACE_TICK){
+            fail("Unknown trace record");
+        }
+        if(record.type != TRACE_TICK && record.asset >= assets_.size()){
+            fail("Trace record names a missing asset");
+        }
+        if(record.type == TRACE_ORDER){
+            if(!validOrder(record)){
+                fail("Trace order has an unknown side, type or time in force");
+            }
+            if(pendingOrders > 0 && record.asset != batchAsset){
+                fail("Trace batch mixes assets");
+            }
+            batchAsset = record.asset;
+            ++pendingOrders;
+            continue;
+        }
+        if(record.type == TRACE_SUBMIT && (record.ordId < 0 || (size_t)record.ordId != pendingOrders ||
+            (pendingOrders > 0 && record.asset != batchAsset))){
+            fail("Trace batch doesn't match the orders before it");
+        }
+        if(record.type == TRACE_MODE && record.tif != CONTINUOUS && record.tif != AUCTION){
+            fail("Trace names an unknown matching mode");
+        }
+        pendingOrders = 0;
+    }
+}
+
+bool TraceReplay::validOrder(const TraceRecord& record){
+    bool validSide = record.side == BUY || record.side == SELL;
+    bool validType = record.ordType >= MARKET && record.ordType <= STOPLIMIT;
+    bool validTif = record.tif == DAY || record.tif == GTC || record.tif == IOC || record.tif == FOK;
+    return validSide && validType && validTif;
+}
+
+TraceReplay::~TraceReplay(){
+    if(data){
+        ::munmap((void*)data, length);
+    }
+}
+
+Order TraceReplay::toOrder(const TraceRecord& record) const{
+    Order order(assets_[record.asset], record.side, record.ordType, record.price, record.qty, record.stopPrice,
+        (TimeInForce)record.tif);
+    order.ordId = (long)record.ordId;
+    order.traderId = (long)record.traderId;
+    order.ordNum = 0;
+    return order;
+}
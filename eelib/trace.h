@@ -0,0 +1,200 @@
+#pragma once
+
+#include "matcher.h"
+#include "order.h"
+#include "symbol.h"
+#include "tick.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+Binary capture of everything an ABM asks of its matchers, for replaying without the agents.
+
+A trace file is a TraceHeader, then fixed size TraceRecords in the order the calls were made, then a table of
+the asset names the records refer to by index. Orders of one addOrders batch are written together, followed
+by a TRACE_SUBMIT for the batch, so a replay hands the books exactly the batches the ABM did and gets exactly
+the same matches. Fields have fixed widths, so traces can be read on any little endian machine.
+*/
+
+enum TraceRecordType : unsigned char {
+
+    /// @brief An order of the batch that the next TRACE_SUBMIT for its asset places
+    TRACE_ORDER = 1,
+
+    /// @brief addOrders with the ordId orders written just before. ordId holds the batch size
+    TRACE_SUBMIT = 2,
+
+    /// @brief cancelOrder(ordId)
+    TRACE_CANCEL = 3,
+
+    /// @brief uncross()
+    TRACE_UNCROSS = 4,
+
+    /// @brief expireDayOrders()
+    TRACE_EXPIRE = 5,
+
+    /// @brief setMode. tif holds the MatchingMode. The first record of every asset is one of these
+    TRACE_MODE = 6,
+
+    /// @brief End of a simulation step. ordId holds the step that ended
+    TRACE_TICK = 7
+};
+
+/// @brief One call on a book. Fields that don't apply to the record type are 0
+struct TraceRecord{
+    std::int64_t ordId;
+    std::int64_t traderId;
+    std::uint32_t qty;
+    /// @brief Index of the asset in the trace's name table
+    std::uint32_t asset;
+    std::uint16_t price;
+    std::uint16_t stopPrice;
+    TraceRecordType type;
+    Side side;
+    OrdType ordType;
+    /// @brief TimeInForce of orders, MatchingMode of TRACE_MODE records
+    unsigned char tif;
+};
+
+static_assert(sizeof(TraceRecord) == 32, "TraceRecord is the on disk layout");
+
+struct TraceHeader{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t recordSize;
+    std::uint64_t numRecords;
+    /// @brief File offset of the name table: for each asset a uint32 length, then the name's bytes
+    std::uint64_t namesOffset;
+    std::uint64_t numAssets;
+};
+
+static_assert(sizeof(TraceHeader) % alignof(TraceRecord) == 0, "Records should start aligned");
+
+/// @brief Writes a trace file. Records are buffered; the header and name table are only complete once closed
+class TraceWriter{
+    std::FILE* file = nullptr;
+    std::vector<TraceRecord> buffer;
+    std::uint64_t numRecords = 0;
+
+    /// @brief Asset - index in names
+    std::unordered_map<Symbol, std::uint32_t> assetIndex;
+    std::vector<std::string> names;
+
+    std::uint32_t indexOf(Symbol asset);
+    void write(const TraceRecord& record);
+    void flush();
+
+    public:
+        /// @brief Create or truncate the file. Throws std::runtime_error if it can't be opened
+        explicit TraceWriter(const std::string& path);
+        ~TraceWriter();
+
+        TraceWriter(const TraceWriter&) = delete;
+        TraceWriter& operator=(const TraceWriter&) = delete;
+
+        void order(const Order& order);
+        void submit(Symbol asset, size_t batchSize);
+        void cancel(Symbol asset, long ordId);
+        void uncross(Symbol asset);
+        void expire(Symbol asset);
+        void mode(Symbol asset, MatchingMode mode);
+        void tickEnded(tick step);
+
+        std::uint64_t size() const { return numRecords; }
+
+        /// @brief Write out the rest and finish the file. Throws std::runtime_error if writing failed. Called by the destructor
+        void close();
+};
+
+/// @brief What a replay handed to the books
+struct TraceReplayStats{
+    size_t orders = 0;
+    size_t batches = 0;
+    size_t cancels = 0;
+    size_t ticks = 0;
+};
+
+/*
+Memory maps a trace and plays it into matchers, one per asset of the trace.
+
+Records are read straight from the mapping; the only copies made are the orders of the batch being submitted.
+*/
+class TraceReplay{
+    const unsigned char* data = nullptr;
+    size_t length = 0;
+    const TraceRecord* records_ = nullptr;
+    size_t numRecords = 0;
+    std::vector<Symbol> assets_;
+
+    /// @brief Reused for every batch
+    std::vector<Order> batch;
+
+    /// @brief Whether an order record's side, type and time in force are values the matcher knows
+    static bool validOrder(const TraceRecord& record);
+
+    public:
+        /// @brief Map a finished trace. Throws std::runtime_error if it can't be read or isn't a complete trace
+        explicit TraceReplay(const std::string& path);
+        ~TraceReplay();
+
+        TraceReplay(const TraceReplay&) = delete;
+        TraceReplay& operator=(const TraceReplay&) = delete;
+
+        size_t size() const { return numRecords; }
+        const TraceRecord* begin() const { return records_; }
+        const TraceRecord* end() const { return records_ + numRecords; }
+
+        /// @brief Assets of the trace, by the index records use
+        const std::vector<Symbol>& assets() const { return assets_; }
+
+        /// @brief Order a TRACE_ORDER record stands for
+        Order toOrder(const TraceRecord& record) const;
+
+        /// @brief Play every record into books[record.asset]. books needs one matcher per asset, ideally fresh.
+        /// MatcherType is any BasicMatcher
+        template<typename MatcherType>
+        TraceReplayStats replay(std::vector<MatcherType>& books);
+};
+
+template<typename MatcherType>
+TraceReplayStats TraceReplay::replay(std::vector<MatcherType>& books){
+    TraceReplayStats stats;
+    for(const TraceRecord* record = records_; record != records_ + numRecords; ++record){
+        switch(record->type){
+            case TRACE_ORDER:
+                // Collected when the batch is submitted
+                break;
+            case TRACE_SUBMIT:{
+                batch.clear();
+                for(const TraceRecord* order = record - record->ordId; order != record; ++order){
+                    batch.push_back(toOrder(*order));
+                }
+                books[record->asset].addOrders(batch);
+                stats.orders += batch.size();
+                ++stats.batches;
+                break;
+            }
+            case TRACE_CANCEL:
+                books[record->asset].cancelOrder((long)record->ordId);
+                ++stats.cancels;
+                break;
+            case TRACE_UNCROSS:
+                books[record->asset].uncross();
+                break;
+            case TRACE_EXPIRE:
+                books[record->asset].expireDayOrders();
+                break;
+            case TRACE_MODE:
+                books[record->asset].setMode((MatchingMode)record->tif);
+                break;
+            case TRACE_TICK:
+                ++stats.ticks;
+                break;
+        }
+    }
+    return stats;
+}
@@ -1,4 +1,5 @@
 #include <emscripten/bind.h>
+#include <emscripten/val.h>
 #include "order.h"
 #include "matcher.h"
 #include "agent.h" 
@@ -6,6 +7,30 @@
 
 using namespace emscripten;
 
+// Orders carry an interned Symbol; JS sees the asset name
+std::string order_get_asset(const Order& order) {
+    return order.asset.name();
+}
+
+void order_set_asset(Order& order, std::string asset) {
+    order.asset = Symbol(asset);
+}
+
+// Observations are read by asset name from JS; undefined for assets without a book
+tick observation_get_time(const Observation& observation) {
+    return observation.time;
+}
+
+val observation_spread(const Observation& observation, std::string asset) {
+    if(!observation.hasBook(Symbol(asset))) return val::undefined();
+    return val(observation.spread(Symbol(asset)));
+}
+
+val observation_depth(const Observation& observation, std::string asset) {
+    if(!observation.hasBook(Symbol(asset))) return val::undefined();
+    return val(observation.depth(Symbol(asset)));
+}
+
 // Helper to manage unique_ptr transfer from JS
 long abm_add_agent(ABM& abm, Agent* agent) {
     return abm.addAgent(std::unique_ptr<Agent>(agent));
@@ -22,6 +47,12 @@ EMSCRIPTEN_BINDINGS(eelib_module) {
         .value("BUY", Side::BUY)
         .value("SELL", Side::SELL);
 
+    enum_<TimeInForce>("TimeInForce")
+        .value("DAY", TimeInForce::DAY)
+        .value("GTC", TimeInForce::GTC)
+        .value("IOC", TimeInForce::IOC)
+        .value("FOK", TimeInForce::FOK);
+
     // Bind tick so we can pass it to Consumer
     class_<tick>("tick")
         .constructor<unsigned long>()
@@ -34,18 +65,22 @@ EMSCRIPTEN_BINDINGS(eelib_module) {
         .field("qty", &Order::qty)
         .field("price", &Order::price)
         .field("stopPrice", &Order::stopPrice)
-        .field("asset", &Order::asset)
-        .field("type", &Order::type);
+        .field("asset", &order_get_asset, &order_set_asset)
+        .field("type", &Order::type)
+        .field("tif", &Order::tif);
 
     value_object<Spread>("Spread")
         .field("bidsMissing", &Spread::bidsMissing)
         .field("asksMissing", &Spread::asksMissing)
         .field("highestBid", &Spread::highestBid)
-        .field("lowestAsk", &Spread::lowestAsk);
+        .field("lowestAsk", &Spread::lowestAsk)
+        .field("highestBidQty", &Spread::highestBidQty)
+        .field("lowestAskQty", &Spread::lowestAskQty);
 
     value_object<PriceBin>("PriceBin")
         .field("price", &PriceBin::price)
-        .field("totalQty", &PriceBin::totalQty);
+        .field("totalQty", &PriceBin::totalQty)
+        .field("numOrders", &PriceBin::numOrders);
 
     // Register std::vector types used in Depth
     register_vector<PriceBin>("VectorPriceBin");
@@ -55,13 +90,10 @@ EMSCRIPTEN_BINDINGS(eelib_module) {
         .field("askBins", &Depth::askBins);
 
     // Bindings for Observation and Action
-    register_map<std::string, Spread>("MapStringSpread");
-    register_map<std::string, Depth>("MapStringDepth");
-
-    value_object<Observation>("Observation")
-        .field("time", &Observation::time)
-        .field("assetSpreads", &Observation::assetSpreads)
-        .field("assetOrderDepths", &Observation::assetOrderDepths);
+    class_<Observation>("Observation")
+        .property("time", &observation_get_time)
+        .function("spread", &observation_spread)
+        .function("depth", &observation_depth);
 
     value_object<Action>("Action")
         .field("placeOrder", &Action::placeOrder)
@@ -83,6 +115,7 @@ EMSCRIPTEN_BINDINGS(eelib_module) {
     class_<ABM>("ABM")
         .constructor<>()
         .function("simStep", &ABM::simStep)
+        .function("setAuctionInterval", &ABM::setAuctionInterval)
         .function("addAgent", &abm_add_agent, allow_raw_pointers())
         .function("getNumAgents", &ABM::getNumAgents)
         .function("getLatestObservation", &ABM::getLatestObservation);
@@ -0,0 +1,248 @@
+#include "workload.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+const char* scenarioName(WorkloadScenario scenario){
+    switch(scenario){
+        case MARKET_MAKING:
+            return "market_making";
+        case MOMENTUM_BURSTS:
+            return "momentum_bursts";
+        case DEEP_BOOK:
+            return "deep_book";
+        case ZIPF_SYMBOLS:
+            return "zipf_symbols";
+    }
+    return "unknown";
+}
+
+bool scenarioFromName(const std::string& name, WorkloadScenario& scenario){
+    for(WorkloadScenario candidate : {MARKET_MAKING, MOMENTUM_BURSTS, DEEP_BOOK, ZIPF_SYMBOLS}){
+        if(name == scenarioName(candidate)){
+            scenario = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+WorkloadParams WorkloadParams::preset(WorkloadScenario scenario){
+    WorkloadParams params;
+    switch(scenario){
+        case MARKET_MAKING:
+            params.midMoveChance = 0.02;
+            params.marketWeight = 0.08;
+            params.limitWeight = 0.47;
+            params.cancelWeight = 0.45;
+            params.maxLimitOffset = 3;
+            params.maxQty = 10;
+            break;
+
+        case MOMENTUM_BURSTS:
+            params.marketWeight = 0.15;
+            params.limitWeight = 0.6;
+            params.stopWeight = 0.15;
+            params.stopLimitWeight = 0.05;
+            params.cancelWeight = 0.05;
+            params.minStopOffset = 3;
+            params.maxStopOffset = 15;
+            params.maxQty = 20;
+            params.burstChance = 0.0005;
+            params.burstLength = 50;
+            params.burstMoveEvery = 4;
+            break;
+
+        case DEEP_BOOK:
+            params.midMoveChance = 0.01;
+            params.marketWeight = 0.02;
+            params.limitWeight = 0.93;
+            params.cancelWeight = 0.05;
+            params.maxLimitOffset = 500;
+            params.maxTrackedOrders = 1 << 16;
+            break;
+
+        case ZIPF_SYMBOLS:
+            params.numSymbols = 1000;
+            params.zipfExponent = 1.1;
+            params.marketWeight = 0.3;
+            params.limitWeight = 0.5;
+            params.cancelWeight = 0.2;
+            break;
+    }
+    return params;
+}
+
+WorkloadGenerator::WorkloadGenerator(const WorkloadParams& params, std::uint64_t seed)
+    : params_(params), rng(seed){
+
+    params_.numSymbols = std::max<size_t>(1, params_.numSymbols);
+    params_.maxLimitOffset = std::max<unsigned short>(1, params_.maxLimitOffset);
+    params_.maxStopOffset = std::max(params_.minStopOffset, params_.maxStopOffset);
+    params_.maxQty = std::max(params_.minQty, params_.maxQty);
+    params_.burstMoveEvery = std::max<size_t>(1, params_.burstMoveEvery);
+    params_.maxTrackedOrders = std::max<size_t>(1, params_.maxTrackedOrders);
+
+    double total = 0;
+    for(size_t k = 0; k < params_.numSymbols; ++k){
+        Symbol asset(params_.symbolPrefix + std::to_string(k));
+        if(asset.id() >= indexById.size()) indexById.resize(asset.id() + 1);
+        indexById[asset.id()] = k;
+        symbols_.push_back(asset);
+
+        // Only the Zipf weights depend on libm, see the class comment
+        total += params_.zipfExponent == 0.0 ? 1.0 : 1.0 / std::pow((double)(k + 1), params_.zipfExponent);
+        symbolCdf.push_back(total);
+    }
+    mids.assign(params_.numSymbols, params_.startPrice);
+    live.resize(params_.numSymbols);
+
+    const double weights[5] = {
+        params_.marketWeight, params_.limitWeight, params_.stopWeight, params_.stopLimitWeight, params_.cancelWeight
+    };
+    double running = 0;
+    for(size_t i = 0; i < 5; ++i){
+        running += std::max(0.0, weights[i]);
+        commandCdf[i] = running;
+    }
+}
+
+double WorkloadGenerator::uniform(){
+    // Top 53 bits, the precision of a double
+    return (double)(rng() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+std::uint64_t WorkloadGenerator::below(std::uint64_t n){
+    // Reject the top partial range so every value is equally likely
+    const std::uint64_t limit = std::numeric_limits<std::uint64_t>::max() - std::numeric_limits<std::uint64_t>::max() % n;
+    std::uint64_t draw;
+    do{
+        draw = rng();
+    } while(draw >= limit);
+    return draw % n;
+}
+
+std::uint64_t WorkloadGenerator::between(std::uint64_t lo, std::uint64_t hi){
+    return lo + below(hi - lo + 1);
+}
+
+size_t WorkloadGenerator::pickSymbol(){
+    if(symbols_.size() == 1) return 0;
+    double target = uniform() * symbolCdf.back();
+    size_t symbol = std::upper_bound(symbolCdf.begin(), symbolCdf.end(), target) - symbolCdf.begin();
+    return std::min(symbol, symbols_.size() - 1);
+}
+
+unsigned short WorkloadGenerator::clampPrice(long price) const{
+    return (unsigned short)std::min<long>(std::numeric_limits<unsigned short>::max(), std::max<long>(1, price));
+}
+
+void WorkloadGenerator::moveMid(size_t symbol, int ticks){
+    mids[symbol] = clampPrice((long)mids[symbol] + ticks);
+}
+
+void WorkloadGenerator::track(size_t symbol, long ordId){
+    std::vector<long>& orders = live[symbol];
+    if(orders.size() < params_.maxTrackedOrders){
+        orders.push_back(ordId);
+    }
+    else{
+        // Forget a random older order to make room
+        orders[below(orders.size())] = ordId;
+    }
+}
+
+EngineCommand WorkloadGenerator::burstOrder(){
+    if((params_.burstLength - burstLeft) % params_.burstMoveEvery == 0){
+        moveMid(burstSymbol, burstSide == BUY ? 1 : -1);
+    }
+    --burstLeft;
+
+    EngineCommand command{ADD_ORDER, ++seq, Order(symbols_[burstSymbol], burstSide, MARKET, 0,
+        (unsigned int)between(params_.minQty, params_.maxQty))};
+    command.order.ordId = command.order.traderId = (long)seq;
+    command.order.ordNum = seq;
+    return command;
+}
+
+EngineCommand WorkloadGenerator::next(){
+    if(burstLeft > 0) return burstOrder();
+
+    if(params_.burstLength > 0 && chance(params_.burstChance)){
+        burstSymbol = pickSymbol();
+        burstSide = chance(0.5) ? BUY : SELL;
+        burstLeft = params_.burstLength;
+        return burstOrder();
+    }
+
+    size_t symbol = pickSymbol();
+    if(chance(params_.midMoveChance)){
+        moveMid(symbol, chance(0.5) ? 1 : -1);
+    }
+
+    double pick = uniform() * commandCdf[4];
+    size_t kind = 0;
+    while(kind < 4 && pick >= commandCdf[kind]) ++kind;
+
+    // Cancel one of the symbol's recent orders. With none to cancel, place a limit instead
+    if(kind == 4 && !live[symbol].empty()){
+        std::vector<long>& orders = live[symbol];
+        size_t victim = below(orders.size());
+        long ordId = orders[victim];
+        orders[victim] = orders.back();
+        orders.pop_back();
+
+        EngineCommand command{CANCEL_ORDER, ++seq, Order{}};
+        command.order.asset = symbols_[symbol];
+        command.order.ordId = ordId;
+        return command;
+    }
+    if(kind == 4) kind = 1;
+
+    const long mid = mids[symbol];
+    Side side = chance(0.5) ? BUY : SELL;
+    int away = side == BUY ? -1 : 1;
+    unsigned int qty = (unsigned int)between(params_.minQty, params_.maxQty);
+
+    Order order;
+    switch(kind){
+        case 0:
+            order = Order(symbols_[symbol], side, MARKET, 0, qty);
+            break;
+        case 1:{
+            // Squared, so most limits rest near the touch and a few far out
+            double u = uniform();
+            long offset = 1 + (long)(u * u * params_.maxLimitOffset);
+            order = Order(symbols_[symbol], side, LIMIT, clampPrice(mid + away * offset), qty);
+            break;
+        }
+        default:{
+            // Buy stops wait above the mid and sell stops below it
+            long offset = (long)between(params_.minStopOffset, params_.maxStopOffset);
+            unsigned short stopPrice = clampPrice(mid - away * offset);
+            if(kind == 2){
+                order = Order(symbols_[symbol], side, STOP, 0, qty, stopPrice);
+            }
+            else{
+                unsigned short price = clampPrice((long)stopPrice - away * (long)params_.stopLimitSlippage);
+                order = Order(symbols_[symbol], side, STOPLIMIT, price, qty, stopPrice);
+            }
+            break;
+        }
+    }
+
+    EngineCommand command{ADD_ORDER, ++seq, order};
+    command.order.ordId = command.order.traderId = (long)seq;
+    command.order.ordNum = seq;
+    if(order.type != MARKET) track(symbol, (long)seq);
+    return command;
+}
+
+std::vector<EngineCommand> WorkloadGenerator::generate(size_t count){
+    std::vector<EngineCommand> commands;
+    commands.reserve(count);
+    for(size_t i = 0; i < count; ++i){
+        commands.push_back(next());
+    }
+    return commands;
+}
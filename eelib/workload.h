@@ -0,0 +1,158 @@
+#pragma once
+
+#include "engine.h"
+#include "order.h"
+#include "symbol.h"
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+enum WorkloadScenario : unsigned char {
+
+    /// @brief Market makers quoting near the touch and canceling most of what they quote
+    MARKET_MAKING = 1,
+
+    /// @brief Calm flow with resting stops, broken by one sided runs of market orders that set off stop cascades
+    MOMENTUM_BURSTS = 2,
+
+    /// @brief Mostly passive limits spread over hundreds of levels, few trades
+    DEEP_BOOK = 3,
+
+    /// @brief Balanced flow over many symbols, picked with Zipf distributed popularity
+    ZIPF_SYMBOLS = 4
+};
+
+/// @brief Lower case name of a scenario, as taken by scenarioFromName
+const char* scenarioName(WorkloadScenario scenario);
+
+/// @return false if name isn't a scenario
+bool scenarioFromName(const std::string& name, WorkloadScenario& scenario);
+
+/// @brief Knobs of a workload. Start from a preset and change what you need
+struct WorkloadParams{
+
+    /// @brief Symbols are named prefix0, prefix1, ...
+    std::string symbolPrefix = "W";
+    size_t numSymbols = 1;
+    /// @brief Symbol k is picked with weight 1 / (k + 1)^zipfExponent. 0 picks every symbol equally
+    double zipfExponent = 0.0;
+
+    /// @brief Mid price every symbol starts at. Each command moves it one tick up or down with midMoveChance
+    unsigned short startPrice = 1000;
+    double midMoveChance = 0.05;
+
+    /// @brief Relative weights of the next command
+    double marketWeight = 1.0;
+    double limitWeight = 1.0;
+    double stopWeight = 0.0;
+    double stopLimitWeight = 0.0;
+    double cancelWeight = 0.0;
+
+    /// @brief Limits rest 1 to maxLimitOffset ticks away from the mid, on their own side
+    unsigned short maxLimitOffset = 10;
+    /// @brief Stops wait minStopOffset to maxStopOffset ticks away from the mid, past it on their trigger side
+    unsigned short minStopOffset = 5;
+    unsigned short maxStopOffset = 20;
+    /// @brief How far past its stop price a stop limit is willing to trade
+    unsigned short stopLimitSlippage = 5;
+
+    unsigned int minQty = 1;
+    unsigned int maxQty = 100;
+
+    /// @brief Chance each command starts a burst of burstLength market orders on one side of one symbol.
+    /// The symbol's mid moves one tick with the burst every burstMoveEvery orders
+    double burstChance = 0.0;
+    size_t burstLength = 0;
+    size_t burstMoveEvery = 4;
+
+    /// @brief Cancels pick among this many of the most recent resting orders of a symbol
+    size_t maxTrackedOrders = 4096;
+
+    static WorkloadParams preset(WorkloadScenario scenario);
+};
+
+/*
+Reproducible stream of orders and cancels.
+
+Everything is drawn from one mt19937_64 seeded with the given seed, with the sampling done here rather than
+by the std distributions, whose output differs between standard libraries. So a scenario and a seed give the
+same commands on every run, and two book implementations can be compared on exactly the same flow.
+Across toolchains that holds while zipfExponent is 0. Zipf weights come from std::pow, whose last bits can
+differ between math libraries and shift which symbol a draw lands on, so compare Zipf flows built with the
+same toolchain.
+
+Commands are EngineCommands numbered from 1, with ordId, traderId and ordNum set to the command number.
+They can go straight to a ShardedEngine, or to one matcher per symbol with applyCommand.
+Cancels name orders the generator sent earlier, which the book may have filled in the meantime.
+*/
+class WorkloadGenerator{
+    WorkloadParams params_;
+    std::mt19937_64 rng;
+    std::vector<Symbol> symbols_;
+    /// @brief Index in symbols_ by Symbol id, for symbolIndex
+    std::vector<size_t> indexById;
+    /// @brief Running sums of the symbol weights, for picking a symbol by binary search
+    std::vector<double> symbolCdf;
+    std::vector<unsigned short> mids;
+    /// @brief Recent resting orders of each symbol, that cancels pick from
+    std::vector<std::vector<long>> live;
+
+    /// @brief Running sums of the command weights: market, limit, stop, stop limit, cancel
+    double commandCdf[5];
+
+    unsigned long seq = 0;
+
+    size_t burstLeft = 0;
+    size_t burstSymbol = 0;
+    Side burstSide = BUY;
+
+    /// @brief Uniform in [0, 1)
+    double uniform();
+    /// @brief Uniform in [0, n)
+    std::uint64_t below(std::uint64_t n);
+    /// @brief Uniform in [lo, hi]
+    std::uint64_t between(std::uint64_t lo, std::uint64_t hi);
+    bool chance(double p) { return uniform() < p; }
+
+    size_t pickSymbol();
+    unsigned short clampPrice(long price) const;
+    void moveMid(size_t symbol, int ticks);
+    void track(size_t symbol, long ordId);
+
+    EngineCommand burstOrder();
+
+    public:
+        WorkloadGenerator(const WorkloadParams& params, std::uint64_t seed);
+        WorkloadGenerator(WorkloadScenario scenario, std::uint64_t seed)
+            : WorkloadGenerator(WorkloadParams::preset(scenario), seed) {}
+
+        EngineCommand next();
+
+        /// @brief The next count commands
+        std::vector<EngineCommand> generate(size_t count);
+
+        const WorkloadParams& params() const { return params_; }
+
+        /// @brief Every symbol the workload trades, in index order
+        const std::vector<Symbol>& symbols() const { return symbols_; }
+
+        /// @brief Index of a workload symbol in symbols(). Only call with symbols of this workload
+        size_t symbolIndex(Symbol asset) const { return indexById[asset.id()]; }
+
+        /// @brief Current mid of a symbol, by index
+        unsigned short mid(size_t symbol) const { return mids[symbol]; }
+};
+
+/// @brief Hand a command to a matcher. The command's order is copied, so commands can be replayed
+/// @return false for cancels of orders no longer on the book
+template<typename MatcherType>
+bool applyCommand(MatcherType& matcher, const EngineCommand& command){
+    if(command.type == CANCEL_ORDER){
+        return matcher.cancelOrder(command.order.ordId);
+    }
+    Order order = command.order;
+    matcher.addOrder(order);
+    return true;
+}